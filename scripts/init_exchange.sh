@@ -48,6 +48,9 @@ rc=$?; if [[ $rc != 0 ]]; then (1>&2 echo "$RESULT"); exit $rc; fi
 set_action_min_auth "start" "admin"
 set_action_min_auth "stop" "admin"
 set_action_min_auth "clrorders" "admin"
+set_action_min_auth "migrorders" "admin"
+set_action_min_auth "setconfig" "admin"
+set_action_min_auth "clrdeadltr" "admin"
 set_action_min_auth "setproxy" "owner"
 set_action_min_auth "setfeerecip" "owner"
 
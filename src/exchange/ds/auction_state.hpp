@@ -0,0 +1,24 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+namespace eosram::ds {
+    using namespace eosio;
+
+    /** Call auction schedule */
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    auction_state_t
+    {
+        uint32_t next_clearing = 0; // time of scheduled clearing, 0 if clearing is not scheduled
+
+        EOSLIB_SERIALIZE(auction_state_t, (next_clearing))
+    };
+
+    struct auction_state : public singleton<"auction"_n, auction_state_t>
+    {
+        auction_state(name owner) :
+            singleton(owner, owner.value)
+        {}
+    };
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <cstdint>
+
+namespace eosram::ds::bancor {
+   /**
+    * Integer implementation of the weight 0.5 Bancor conversion of eosio.system rammarket.
+    *
+    * System contract computes conversions in double precision (see ram_exchange_state.cpp).
+    * Functions below emulate each IEEE-754 double operation of that computation
+    * (division, addition, multiplication and square root, all rounded to nearest even)
+    * with exact integer arithmetic, so the result is bit-for-bit equal to the double one
+    * without going through softfloat.
+    *
+    * Note: libc of eosio.cdt computes std::pow(x, 0.5) as sqrt(x) and std::pow(x, 2.0) as x*x,
+    *       which are both correctly rounded operations.
+    *
+    * Precondition: all inputs are positive and less than 2^53 (exactly representable as double),
+    *               see in_domain.
+    */
+    namespace detail {
+        using u128 = unsigned __int128;
+
+        static constexpr int32_t  mantissa_bits = 53;
+        static constexpr uint64_t max_exact     = 1ULL << mantissa_bits;
+
+        /** Double value m * 2^e */
+        struct fp64
+        {
+            u128    m;
+            int32_t e;
+        };
+
+        inline int32_t bit_length(u128 v)
+        {
+            int32_t n = 0;
+            if(v >> 64) {
+                n = 64;
+                v >>= 64;
+            }
+
+            uint64_t v64 = static_cast<uint64_t>(v);
+            while(v64 != 0) {
+                n++;
+                v64 >>= 1;
+            }
+            return n;
+        }
+
+        /** Rounds m * 2^e to double (53 significant bits, ties to even) */
+        inline fp64 round(u128 m, int32_t e)
+        {
+            const int32_t shift = bit_length(m) - mantissa_bits;
+            if(shift <= 0) {
+                return { m, e };
+            }
+
+            const u128 half = u128(1) << (shift - 1);
+            const u128 rem  = m & ((u128(1) << shift) - 1);
+            m >>= shift;
+            if(rem > half || (rem == half && (m & 1))) {
+                m++; // might carry into 54th bit, value is still exact
+            }
+            return { m, e + shift };
+        }
+
+        /** Returns double division t / c, 0 < t < c */
+        inline fp64 div(uint64_t t, uint64_t c)
+        {
+            int32_t k = mantissa_bits - 1 + bit_length(c) - bit_length(t);
+            u128 n = u128(t) << k;
+            u128 q = n / c;
+            if(q < (u128(1) << (mantissa_bits - 1)))
+            {
+                k++;
+                n <<= 1;
+                q = n / c;
+            }
+
+            const u128 r = n - q * c;
+            if(2 * r > c || (2 * r == c && (q & 1))) {
+                q++;
+            }
+            return { q, -k };
+        }
+
+        /** Returns double addition 1 + v, v < 1 */
+        inline fp64 add_one(const fp64& v)
+        {
+            return round((u128(1) << -v.e) + v.m, v.e);
+        }
+
+        /** Returns double square root of v, v >= 1 */
+        inline fp64 sqrt(fp64 v)
+        {
+            // Scale v to 105 or 106 bits with even exponent so root has 53 bits
+            int32_t sh = 106 - bit_length(v.m);
+            if((v.e - sh) & 1) {
+                sh--;
+            }
+
+            const u128 n = v.m << sh;
+            const int32_t e = v.e - sh;
+
+            // Integer square root, bit by bit
+            u128 x = n;
+            u128 r = 0;
+            u128 b = u128(1) << 104;
+            while(b > x) {
+                b >>= 2;
+            }
+
+            while(b != 0)
+            {
+                if(x >= r + b)
+                {
+                    x -= r + b;
+                    r = (r >> 1) + b;
+                }
+                else {
+                    r >>= 1;
+                }
+                b >>= 2;
+            }
+
+            // sqrt(n) can't be half way between two integers
+            if(n - r * r > r) {
+                r++;
+            }
+            return { r, e / 2 };
+        }
+
+        /** Returns exact v - 1, v >= 1 and exponent of v >= -126 */
+        inline fp64 sub_one(const fp64& v)
+        {
+            return { v.m - (u128(1) << -v.e), v.e };
+        }
+
+        /** Returns double multiplication a * b */
+        inline fp64 mul(uint64_t a, const fp64& b)
+        {
+            return round(u128(a) * b.m, b.e);
+        }
+
+        inline fp64 sqr(const fp64& a)
+        {
+            return round(a.m * a.m, 2 * a.e);
+        }
+
+        /** Returns int64_t(v), v >= 0 */
+        inline int64_t trunc(const fp64& v)
+        {
+            if(v.e >= 0) {
+                return static_cast<int64_t>(v.m << v.e);
+            }
+            return v.e <= -128 ? 0 : static_cast<int64_t>(v.m >> -v.e);
+        }
+    }
+
+   /**
+    * Returns true if the integer implementation can be used for given conversion inputs.
+    * Inputs and balance + in must be exactly representable as double.
+    */
+    inline bool in_domain(int64_t supply, int64_t balance, int64_t in)
+    {
+        using detail::max_exact;
+        return supply > 0 && balance > 0 && in > 0 &&
+            uint64_t(supply) < max_exact && uint64_t(balance) + uint64_t(in) < max_exact;
+    }
+
+   /**
+    * Emulates convert_to_exchange:
+    *   int64_t(-R * (1 - std::pow(1 + T / C, 0.5)))
+    * where R = supply, C = balance + in, T = in
+    */
+    inline int64_t to_exchange(int64_t supply, int64_t balance, int64_t in)
+    {
+        using namespace detail;
+        const uint64_t c = uint64_t(balance) + uint64_t(in);
+
+        // 1 - s is exact because 1 <= s < sqrt(2)
+        const fp64 a = add_one(div(uint64_t(in), c));
+        const fp64 u = sub_one(detail::sqrt(a));
+        return trunc(mul(uint64_t(supply), u));
+    }
+
+   /**
+    * Emulates convert_from_exchange:
+    *   int64_t(C * (std::pow(1 + E / R, 2) - 1))
+    * where R = supply - in, C = balance, E = in
+    * Requires in < supply - in.
+    */
+    inline int64_t from_exchange(int64_t supply, int64_t balance, int64_t in)
+    {
+        using namespace detail;
+        const uint64_t r = uint64_t(supply) - uint64_t(in);
+
+        // p - 1 is exact because 1 <= p <= 4
+        const fp64 a = add_one(div(uint64_t(in), r));
+        const fp64 d = sub_one(sqr(a));
+        return trunc(mul(uint64_t(balance), d));
+    }
+}
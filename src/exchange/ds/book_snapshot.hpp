@@ -0,0 +1,39 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+
+#include <vector>
+
+#include "../types.hpp"
+
+namespace eosram::ds {
+   /**
+    * Order as exported by the book snapshot.
+    * Same as order_t row without the queue seq, value symbol is implied by the book side.
+    */
+    struct snapshot_order_t
+    {
+        order_id_t  id;
+        int64_t     amount;
+        eosio::name trader;
+        uint32_t    expiration_time;
+        uint8_t     flags;
+
+        EOSLIB_SERIALIZE(snapshot_order_t, (id)(amount)(trader)(expiration_time)(flags))
+    };
+
+   /**
+    * Batch of orders in book (FIFO) order.
+    * Version is the book version at the time of snapshot, if it changes
+    * between batches the book was modified and the reader should start over.
+    */
+    struct book_snapshot_t
+    {
+        uint64_t version = 0;
+        uint64_t cursor  = 0;     // seq to continue from
+        bool     more    = false; // there are orders after this batch
+        std::vector<snapshot_order_t> orders;
+
+        EOSLIB_SERIALIZE(book_snapshot_t, (version)(cursor)(more)(orders))
+    };
+}
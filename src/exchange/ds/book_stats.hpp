@@ -0,0 +1,30 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * Aggregates of the order book.
+    * Maintained incrementally by order_book on every insert, modify and erase
+    * so the book can be summarized without iterating it.
+    */
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    book_stats_t
+    {
+        uint64_t orders  = 0; // number of orders in the book
+        int64_t  value   = 0; // sum of order amounts in book side's token
+        uint64_t version = 0; // incremented on every change of the book
+
+        EOSLIB_SERIALIZE(book_stats_t, (orders)(value)(version))
+    };
+
+    struct book_stats : public singleton<"bookstats"_n, book_stats_t>
+    {
+        book_stats(name owner, uint64_t book_scope) :
+            singleton(owner, book_scope)
+        {}
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+
+#include <algorithm>
+#include <optional>
+
+#include "../constants.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * OHLCV candle of RAM price in EOS per KiB.
+    * Candles of one resolution are stored in table scope equal to resolution in seconds,
+    * in ring of fixed number of slots, the oldest candle is overwritten.
+    */
+    struct [[eosio::table("candles"), eosio::contract("eosram.exchange")]]
+    candle_t
+    {
+        uint64_t slot;
+        uint32_t start;      // candle open time
+        int64_t  open;
+        int64_t  high;
+        int64_t  low;
+        int64_t  close;
+        int64_t  volume_eos; // traded EOS token
+        int64_t  volume_ram; // traded RAM token
+
+        uint64_t primary_key() const { return slot; }
+
+        EOSLIB_SERIALIZE(candle_t, (slot)(start)(open)(high)(low)(close)(volume_eos)(volume_ram))
+    };
+
+    /** Candles of single resolution, current candle is written once when the series goes out of scope */
+    template<uint32_t Resolution, uint32_t Retention>
+    class candle_series
+    {
+        using candles_t = multi_index<"candles"_n, candle_t>;
+
+    public:
+        candle_series(name owner) :
+            candles_(owner, Resolution)
+        {}
+
+        ~candle_series() {
+            flush();
+        }
+
+        void update(uint32_t time, int64_t price, int64_t eos_amount, int64_t ram_amount)
+        {
+            const uint32_t start = time - time % Resolution;
+            if(!candle_ || candle_->start != start)
+            {
+                flush();
+                load(start, price);
+            }
+
+            auto& c = *candle_;
+            c.high  = std::max(c.high, price);
+            c.low   = std::min(c.low, price);
+            c.close = price;
+            c.volume_eos += eos_amount;
+            c.volume_ram += ram_amount;
+            dirty_ = true;
+        }
+
+    private:
+        void load(uint32_t start, int64_t price)
+        {
+            const uint64_t slot = (start / Resolution) % Retention;
+            auto it = candles_.find(slot);
+            stored_ = it != candles_.end();
+            if(stored_ && it->start == start) {
+                candle_ = *it;
+                return;
+            }
+
+            // New candle, overwrites the oldest one
+            candle_ = candle_t{ slot, start, price, price, price, price, 0, 0 };
+        }
+
+        void flush()
+        {
+            if(!dirty_) {
+                return;
+            }
+
+            const auto payer = candles_.get_code();
+            if(stored_) {
+                candles_.modify(candles_.find(candle_->slot), payer, [&](auto& c) { c = *candle_; });
+            }
+            else {
+                candles_.emplace(payer, [&](auto& c) { c = *candle_; });
+            }
+
+            stored_ = true;
+            dirty_  = false;
+        }
+
+    private:
+        candles_t candles_;
+        std::optional<candle_t> candle_;
+        bool stored_ = false;
+        bool dirty_  = false;
+    };
+
+    /** 1 minute and 1 hour candles */
+    struct candles
+    {
+        candles(name owner) :
+            m1(owner),
+            h1(owner)
+        {}
+
+        void update(uint32_t time, int64_t price, int64_t eos_amount, int64_t ram_amount)
+        {
+            m1.update(time, price, eos_amount, ram_amount);
+            h1.update(time, price, eos_amount, ram_amount);
+        }
+
+        candle_series<60,   candles_1m_retention> m1;
+        candle_series<3600, candles_1h_retention> h1;
+    };
+}
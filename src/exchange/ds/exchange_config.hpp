@@ -0,0 +1,54 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+#include "../constants.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * Runtime tunable execution parameters.
+    * When table is not set, compile-time defaults from constants.hpp are used.
+    */
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    config_t
+    {
+        uint32_t execution_limit      = order_execution_limit;  // max orders matched per execution pass
+        uint32_t execution_delay      = order_execution_delay;  // delay in seconds of the next execution pass
+        uint32_t onerror_resend_delay = eosram::onerror_resend_delay;
+        int32_t  min_ttl              = eosram::min_ttl;
+        int64_t  transfer_fee_in_ram  = eosram::transfer_fee_in_ram;
+        uint32_t clrorders_batch_size = eosram::clrorders_batch_size; // refund transfers per clrorders pass
+        uint32_t auction_interval     = eosram::auction_interval;     // seconds between call auction clearings
+        uint32_t max_open_orders      = eosram::max_open_orders;      // max open orders of single trader
+        uint32_t quota_window         = eosram::quota_window;         // seconds of trader's order rate window
+        uint32_t max_window_orders    = eosram::max_window_orders;    // max orders trader can make in quota window
+
+        void validate() const
+        {
+            eosio_assert(execution_limit > 0 && execution_limit <= max_order_execution_limit, "config: invalid execution_limit!");
+            eosio_assert(execution_delay > 0 && execution_delay <= max_config_delay, "config: invalid execution_delay!");
+            eosio_assert(onerror_resend_delay > 0 && onerror_resend_delay <= max_config_delay, "config: invalid onerror_resend_delay!");
+            eosio_assert(min_ttl > 0, "config: invalid min_ttl!");
+            eosio_assert(transfer_fee_in_ram > 0 && transfer_fee_in_ram <= min_ram_trade_amount, "config: invalid transfer_fee_in_ram!");
+            eosio_assert(clrorders_batch_size > 0 && clrorders_batch_size <= max_order_execution_limit, "config: invalid clrorders_batch_size!");
+            eosio_assert(auction_interval > 0 && auction_interval <= max_config_delay, "config: invalid auction_interval!");
+            eosio_assert(max_open_orders >= max_batch_orders, "config: invalid max_open_orders!");
+            eosio_assert(quota_window > 0 && quota_window <= max_config_delay, "config: invalid quota_window!");
+            eosio_assert(max_window_orders >= max_batch_orders, "config: invalid max_window_orders!");
+        }
+
+        EOSLIB_SERIALIZE(config_t, (execution_limit)(execution_delay)(onerror_resend_delay)
+            (min_ttl)(transfer_fee_in_ram)(clrorders_batch_size)(auction_interval)
+            (max_open_orders)(quota_window)(max_window_orders))
+    };
+
+    struct exchange_config : public singleton<"config"_n, config_t>
+    {
+        exchange_config(name owner) :
+            singleton(owner, owner.value)
+        {}
+    };
+}
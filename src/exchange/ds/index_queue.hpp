@@ -19,17 +19,66 @@ namespace eosram::ds {
         EOSLIB_SERIALIZE(index_queue_element, (seq))
     };
 
-    template<eosio::name::raw QueueName, typename ValueType,  typename... Indices>
-    class index_queue
+    namespace key_policy {
+        /** Primary key is queue sequence number, elements are found by secondary indices. */
+        struct seq_primary
+        {
+            static constexpr eosio::name::raw key_name = eosio::name::raw(0);
+        };
+
+       /**
+        * Primary key is element's key extracted by KeyExtractor,
+        * queue (FIFO) order is kept by secondary index on sequence number.
+        * Elements are found by KeyName without reading secondary index, seq index
+        * is read only when iterator returned by find is moved or erased.
+        */
+        template<eosio::name::raw KeyName, typename KeyExtractor>
+        struct key_primary
+        {
+            static constexpr eosio::name::raw key_name = KeyName;
+            using key_extractor = KeyExtractor;
+        };
+    }
+
+    namespace detail {
+        static constexpr eosio::name::raw index_queue_seq_index = "seq"_n;
+
+        struct no_seq_index {};
+
+        template<bool SeqPrimary, typename Q>
+        struct seq_index_of { using type = no_seq_index; };
+
+        template<typename Q>
+        struct seq_index_of<false, Q> {
+            using type = decltype(std::declval<Q&>().template get_index<index_queue_seq_index>());
+        };
+    }
+
+   /**
+    * FIFO queue stored in multi_index table.
+    * KeyPolicy selects at compile time which key is the table's primary key (see key_policy).
+    */
+    template<typename KeyPolicy, eosio::name::raw QueueName, typename ValueType,  typename... Indices>
+    class basic_index_queue
     {
         static_assert(std::is_base_of<index_queue_element, ValueType>::value, 
                 "ValueType must inherit from index_queue_element!");
 
+        static constexpr bool seq_primary = std::is_same<KeyPolicy, key_policy::seq_primary>::value;
+
         struct qe_t : ValueType
         {
             operator ValueType& () { return *this; };
             operator const ValueType& () const { return *this; };
-            uint64_t primary_key() const { return index_queue_element::seq; }
+            uint64_t get_seq() const { return index_queue_element::seq; }
+            uint64_t primary_key() const
+            {
+                if constexpr(seq_primary) {
+                    return index_queue_element::seq;
+                } else {
+                    return typename KeyPolicy::key_extractor()(static_cast<const ValueType&>(*this));
+                }
+            }
             
             template<typename DataStream>
             friend DataStream& operator << ( DataStream& ds, const qe_t& t )
@@ -46,30 +95,44 @@ namespace eosram::ds {
             } 
         };
 
-        using q_t = multi_index<QueueName, qe_t, Indices...>;
+        using q_t = std::conditional_t<seq_primary,
+            multi_index<QueueName, qe_t, Indices...>,
+            multi_index<QueueName, qe_t,
+                indexed_by<detail::index_queue_seq_index, const_mem_fun<qe_t, uint64_t, &qe_t::get_seq>>,
+                Indices...
+            >
+        >;
+
+        // Index which keeps queue order
+        using seq_index_t = typename detail::seq_index_of<seq_primary, q_t>::type;
+        using ordered_t   = std::conditional_t<seq_primary, q_t, seq_index_t>;
         static constexpr auto max_seq = std::numeric_limits<uint64_t>::max() - 1;
 
     public:
+       /**
+        * Iterator found by primary key (see find) holds only the element,
+        * it's position in queue order is looked up when the iterator is moved or erased.
+        */
         struct const_iterator : public std::iterator<std::bidirectional_iterator_tag, const ValueType> 
         {
             friend bool operator == ( const const_iterator& a, const const_iterator& b ) 
             {
-                return a.it_ == b.it_;
+                return a.element_ptr() == b.element_ptr();
             }
 
             friend bool operator != ( const const_iterator& a, const const_iterator& b ) 
             {
-                return a.it_ != b.it_;
+                return !(a == b);
             }
 
             const ValueType& operator*() const
             {
-                return *it_; 
+                return element();
             }
 
             const ValueType* operator->() const
             {
-                return &(*it_);
+                return &element();
             }
 
             const_iterator operator++(int)
@@ -88,30 +151,62 @@ namespace eosram::ds {
 
             const_iterator& operator++()
             {
-                it_++;
+                ++resolve();
                 return *this;
             }
 
             const_iterator& operator--()
             {
-                it_--;
+                --resolve();
                 return *this;
             }
 
             uint64_t internal_idx() const
             {
-                return it_->seq;
+                return element().seq;
             }
 
         private:
-            using qi_it_t = typename q_t::const_iterator;
-            const_iterator(qi_it_t it) : 
-                it_(std::move(it)) 
+            using qi_it_t = typename ordered_t::const_iterator;
+            const_iterator(ordered_t& ordered, qi_it_t it) :
+                idx_(&ordered),
+                it_(std::move(it))
+            {}
+
+            const_iterator(ordered_t& ordered, const qe_t& element) :
+                idx_(&ordered),
+                element_(&element)
             {}
 
+            const qe_t& element() const
+            {
+                if(element_ != nullptr) {
+                    return *element_;
+                }
+                return *(*it_);
+            }
+
+            const qe_t* element_ptr() const
+            {
+                if(element_ != nullptr) {
+                    return element_;
+                }
+                return *it_ != idx_->end() ? &(*(*it_)) : nullptr;
+            }
+
+            qi_it_t& resolve() const
+            {
+                if(!it_)
+                {
+                    it_ = idx_->iterator_to(*element_);
+                    element_ = nullptr;
+                }
+                return *it_;
+            }
+
             const qi_it_t& get_underlying_it() const
             {
-                return it_;
+                return resolve();
             }
 
             operator const qi_it_t& () const
@@ -120,24 +215,31 @@ namespace eosram::ds {
             }
 
         private:
-            qi_it_t it_;
-            friend class index_queue;
+            ordered_t* idx_;
+            mutable std::optional<qi_it_t> it_;
+            mutable const qe_t* element_ = nullptr;
+            friend class basic_index_queue;
         };
 
 
         // Constructor
-        index_queue(eosio::name code, uint64_t scope) : 
-            qi_(code, scope)
+        basic_index_queue(eosio::name code, uint64_t scope) : 
+            qi_(code, scope),
+            sidx_(make_seq_index())
         {}
 
+        // Seq index refers to this queue's table
+        basic_index_queue(const basic_index_queue&) = delete;
+        basic_index_queue& operator = (const basic_index_queue&) = delete;
+
         const_iterator begin() const
         {
-            return qi_.begin();
+            return const_iterator(ordered_(), ordered_().begin());
         }
 
         const_iterator end() const
         {
-            return qi_.end();
+            return const_iterator(ordered_(), ordered_().end());
         }
 
         template<eosio::name::raw IndexName, typename Key>
@@ -159,22 +261,39 @@ namespace eosram::ds {
 
         const_iterator erase(const_iterator it)
         {
-            auto rit = qi_.erase(it);
-            eosio_assert(it.get_underlying_it() != qi_.end(), "Queue element was not erased properly!");
-            return rit;
+            auto rit = ordered_().erase(it);
+            eosio_assert(it.get_underlying_it() != ordered_().end(), "Queue element was not erased properly!");
+            return const_iterator(ordered_(), std::move(rit));
         }
 
         template<eosio::name::raw  IndexName, typename Key>
         const_iterator find(const Key& k) const
         {
-            auto idx = qi_.template get_index<IndexName>();
-            auto it = idx.find(k);
-            if(it != idx.end()) {
-                return qi_.iterator_to(*it);
+            if constexpr(!seq_primary && IndexName == KeyPolicy::key_name)
+            {
+                // Position in seq index is looked up only if the iterator is moved or erased
+                auto it = qi_.find(k);
+                if(it != qi_.end()) {
+                    return const_iterator(ordered_(), *it);
+                }
+            }
+            else
+            {
+                auto idx = qi_.template get_index<IndexName>();
+                auto it = idx.find(k);
+                if(it != idx.end()) {
+                    return const_iterator(ordered_(), ordered_().iterator_to(*it));
+                }
             }
             return end();
         }
 
+        /** Returns iterator to the first element with seq not less than given seq */
+        const_iterator lower_bound(uint64_t seq) const
+        {
+            return const_iterator(ordered_(), ordered_().lower_bound(seq));
+        }
+
         eosio::name get_code() const
         {
             return qi_.get_code();
@@ -188,7 +307,7 @@ namespace eosram::ds {
         void modify(const_iterator it, ValueType value, eosio::name payer) 
         {
             eosio_assert(it != end(), "Cannot modify index_queue element, invalid iterator!");
-            qi_.modify(it, payer, [&](auto& qe) {
+            qi_.modify(it.element(), payer, [&](auto& qe) {
                 auto seq = qe.seq;
                 qe = static_cast<qe_t&&>(std::move(value));
                 qe.seq = seq;
@@ -198,8 +317,8 @@ namespace eosram::ds {
         std::optional<ValueType> pop()
         {
             std::optional<ValueType> v;
-            auto it = qi_.begin();
-            if(it != qi_.end()) 
+            auto it = begin();
+            if(it != end()) 
             {
                 v = std::move(*it);
                 erase(it);
@@ -211,8 +330,8 @@ namespace eosram::ds {
         void push(ValueType value, eosio::name payer)
         {
             uint64_t seq = 0;
-            auto it = qi_.rbegin();
-            if(it != qi_.rend()) 
+            auto it = ordered_().rbegin();
+            if(it != ordered_().rend()) 
             {
                 seq = it->seq + 1;
                 eosio_assert(seq < max_seq, "Cannot push element to queue, seq is at max limit");
@@ -226,10 +345,40 @@ namespace eosram::ds {
 
         const_iterator top() const
         {
-            return qi_.begin();
+            return begin();
+        }
+
+    private:
+        seq_index_t make_seq_index()
+        {
+            if constexpr(seq_primary) {
+                return seq_index_t{};
+            } else {
+                return qi_.template get_index<detail::index_queue_seq_index>();
+            }
+        }
+
+        ordered_t& ordered_() const
+        {
+            if constexpr(seq_primary) {
+                return qi_;
+            } else {
+                return sidx_;
+            }
         }
 
     private:
-        q_t qi_;
+        mutable q_t qi_;
+        mutable seq_index_t sidx_;
+    };
+
+    /** FIFO queue with sequence number as primary key */
+    template<eosio::name::raw QueueName, typename ValueType, typename... Indices>
+    class index_queue : public basic_index_queue<key_policy::seq_primary, QueueName, ValueType, Indices...>
+    {
+    public:
+        index_queue(eosio::name code, uint64_t scope) :
+            basic_index_queue<key_policy::seq_primary, QueueName, ValueType, Indices...>(code, scope)
+        {}
     };
 }
\ No newline at end of file
@@ -2,4 +2,5 @@
 #include "memo_cmd.hpp"
 #include "memo_cmd_cancel_order.hpp"
 #include "memo_cmd_make_order.hpp"
+#include "memo_cmd_make_orders.hpp"
 #include "memo_parser.hpp"
\ No newline at end of file
@@ -98,7 +98,8 @@ namespace eosram::ds {
     private:
         void set_ttl(ttl_t ttl)
         {
-            eosio_assert(ttl_valid(ttl), "memo_cmd_make_order: Invalid TTL!");
+            // Lower bound of ttl is runtime configurable and is checked by the exchange
+            eosio_assert(ttl_valid(ttl, 1), "memo_cmd_make_order: Invalid TTL!");
             ttl_ = std::max(ttl, infinite_ttl);
             set_convert(convert_); // reset convert on expire if ttl is infinite
         }
@@ -0,0 +1,148 @@
+#pragma once
+#include <eosiolib/asset.hpp>
+
+#include "../../constants.hpp"
+#include "../../types.hpp"
+#include "../../utils.hpp"
+#include "memo_cmd_make_order.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace eosram::ds {
+    using namespace std::string_view_literals;
+
+    /** Order made by memo_cmd_make_orders */
+    struct order_entry_t
+    {
+        eosio::asset value;
+        ttl_t ttl;
+        bool convert_on_expire;
+
+        EOSLIB_SERIALIZE(order_entry_t, (value)(ttl)(convert_on_expire))
+    };
+
+   /**
+    * Splits deposit into several orders.
+    * Memo format: orders:<weight>[,<ttl>[,convert]];<weight>[,<ttl>[,convert]];...
+    * Each order gets deposit * weight / sum of weights, the last one gets the remainder.
+    * Ttl and convert arg of order have the same meaning as in memo_cmd_make_order.
+    */
+    class memo_cmd_make_orders : public memo_cmd<memo_cmd_make_orders>
+    {
+    public:
+        struct leg
+        {
+            uint32_t weight;
+            memo_cmd_make_order cmd;
+        };
+
+        static constexpr memo_cmd_type type() {
+            return memo_cmd_type(0x0bde25);
+        }
+
+        static constexpr std::string_view cmd_tag() {
+            return "orders"sv;
+        }
+
+        static constexpr std::string_view arg_delim() {
+            return ":"sv;
+        }
+
+        static constexpr std::string_view order_delim() {
+            return ";"sv;
+        }
+
+        static constexpr std::string_view weight_delim() {
+            return ","sv;
+        }
+
+        const std::vector<leg>& legs() const {
+            return legs_;
+        }
+
+        /** Splits value into orders by weight */
+        std::vector<order_entry_t> split(const eosio::asset& value) const
+        {
+            uint64_t total_weight = 0;
+            for(const auto& l : legs_) {
+                total_weight += l.weight;
+            }
+
+            std::vector<order_entry_t> orders;
+            orders.reserve(legs_.size());
+
+            int64_t remaining = value.amount;
+            for(std::size_t i = 0; i < legs_.size(); i++)
+            {
+                const auto& l = legs_[i];
+                const int64_t amount = i + 1 == legs_.size() ? remaining :
+                    static_cast<int64_t>((int128_t(value.amount) * l.weight) / total_weight);
+
+                remaining -= amount;
+                orders.push_back({ eosio::asset(amount, value.symbol), l.cmd.ttl(), l.cmd.convert_on_expire() });
+            }
+            return orders;
+        }
+
+        std::string to_string() const
+        {
+            std::string memo(cmd_tag());
+            memo.append(arg_delim());
+            for(std::size_t i = 0; i < legs_.size(); i++)
+            {
+                if(i > 0) {
+                    memo.append(order_delim());
+                }
+
+                memo.append(eosram::to_string(static_cast<int32_t>(legs_[i].weight)));
+                auto cmd = legs_[i].cmd.to_string();
+                if(!cmd.empty()) {
+                    memo.append(weight_delim()).append(cmd);
+                }
+            }
+            return memo;
+        }
+
+        static memo_cmd_make_orders parse(const std::string& memo, std::size_t& ofs)
+        {
+            memo_cmd_make_orders cmd;
+            while(ofs < memo.size())
+            {
+                auto end = memo.find(order_delim(), ofs);
+                if(end == memo.npos) {
+                    end = memo.size();
+                }
+
+                const std::string_view order_memo(memo.data() + ofs, end - ofs);
+                std::size_t parse_pos = 0UL;
+                const int32_t weight = to_number(order_memo, &parse_pos);
+                eosio_assert(parse_pos != 0 && weight > 0, "memo_cmd_make_orders: Invalid order weight!");
+
+                std::string order_args;
+                if(parse_pos != order_memo.size())
+                {
+                    eosio_assert(str_contains_at(order_memo, parse_pos, weight_delim()),
+                        "memo_cmd_make_orders: Invalid arg delim!");
+                    order_args = std::string(order_memo.substr(parse_pos + weight_delim().size()));
+                    eosio_assert(!order_args.empty(), "memo_cmd_make_orders: Invalid memo!");
+                }
+
+                std::size_t order_ofs = 0UL;
+                cmd.legs_.push_back({ static_cast<uint32_t>(weight), memo_cmd_make_order::parse(order_args, order_ofs) });
+                eosio_assert(cmd.legs_.size() <= max_batch_orders, "memo_cmd_make_orders: Too many orders!");
+
+                ofs = end == memo.size() ? end : end + order_delim().size();
+                eosio_assert(ofs < memo.size() || end == memo.size(), "memo_cmd_make_orders: Invalid memo!");
+            }
+
+            eosio_assert(!cmd.legs_.empty(), "memo_cmd_make_orders: No orders!");
+            return cmd;
+        }
+
+    private:
+        memo_cmd_make_orders() = default;
+        std::vector<leg> legs_;
+    };
+}
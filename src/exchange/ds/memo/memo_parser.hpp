@@ -8,6 +8,7 @@
 #include "memo_cmd.hpp"
 #include "memo_cmd_cancel_order.hpp"
 #include "memo_cmd_make_order.hpp"
+#include "memo_cmd_make_orders.hpp"
 #include "../../log.hpp"
 
 namespace eosram::ds {
@@ -54,6 +55,17 @@ namespace eosram::ds {
                 ofs_ = cmd_tag.size() + delim.size();
                 ofs_ = std::min(ofs_, memo_.size());
             } 
+            // make_orders cmd
+            else if(memo_starts_with(memo_cmd_make_orders::cmd_tag()))
+            {
+                auto cmd_tag = memo_cmd_make_orders::cmd_tag();
+                auto delim = memo_cmd_make_orders::arg_delim();
+
+                eosio_assert(memo_contains_at(delim, cmd_tag.size()), "memo_parser: Invalid arg delimiter!");
+
+                cmd_ = memo_cmd_make_orders::type();
+                ofs_ = cmd_tag.size() + delim.size();
+            }
             else { // make_order cmd
                 cmd_ = memo_cmd_make_order::type();
             }
@@ -3,7 +3,9 @@
 #include <eosiolib/asset.hpp>
 #include <eosiolib/name.hpp>
 
+#include "book_stats.hpp"
 #include "index_queue.hpp"
+#include "paged_queue.hpp"
 #include "../constants.hpp"
 #include "../log.hpp"
 #include "../types.hpp"
@@ -12,46 +14,170 @@
 namespace eosram::ds {
     using namespace eosio;
 
+    namespace order_flags {
+        static constexpr uint8_t convert_on_expire = 0x01; // if set, when order expires the RAM token will be issued (or burned) instead of exchanged and
+                                                           // equal amount of RAM will be bought/sold on rammarket.
+        static constexpr uint8_t sell_order        = 0x02; // order's value is in RAM token, otherwise in EOS token
+        static constexpr uint8_t legacy_layout     = 0x80; // transient, set when order was read from legacy row layout
+    }
+
+   /**
+    * Packed order row.
+    * Symbol of order's value is implied by the order side and stored as flag,
+    * order flags are bit-packed into single byte.
+    *
+    * Row layout:      seq(8) id(8) amount(8) trader(8) expiration_time(4) flags(1) = 37 bytes
+    * Legacy layout:   seq(8) id(8) value(16) trader(8) expiration_time(4) convert_on_expire(1) = 45 bytes
+    */
     struct [[eosio::table("orderbook"), eosio::contract("eosram.exchange")]] order_t : index_queue_element
     {
+        static constexpr uint32_t packed_row_size = 37;
+        static constexpr uint32_t legacy_row_size = 45;
+
         order_id_t id;
-        asset value;
+        int64_t amount;
         eosio::name trader;
         uint32_t expiration_time;
-        bool convert_on_expire;  // if true, when order expires the RAM token will be issued (or burned) instead of exchanged and
-                                 // equal amount of RAM will be bought/sold on rammarket.
+        uint8_t flags;
 
         order_t() = default;
         order_t(order_id_t oid, asset v, eosio::name t, uint32_t etime, bool exe_on_expire) :
-            id(oid), value(v), trader(t),
+            id(oid), amount(0), trader(t),
             expiration_time(etime),
-            convert_on_expire(exe_on_expire)
-        {}
+            flags(0)
+        {
+            set_value(v);
+            set_convert_on_expire(exe_on_expire);
+        }
+
+        asset value() const {
+            return asset(amount, is_sell_order() ? RAM_SYMBOL : EOS_SYMBOL);
+        }
+
+        void set_value(const asset& v)
+        {
+            eosio_assert(v.symbol == EOS_SYMBOL || v.symbol == RAM_SYMBOL, "order_t: invalid order value symbol!");
+            amount = v.amount;
+            set_flag(order_flags::sell_order, v.symbol == RAM_SYMBOL);
+        }
+
+        constexpr bool is_sell_order() const {
+            return flags & order_flags::sell_order;
+        }
+
+        constexpr bool convert_on_expire() const {
+            return flags & order_flags::convert_on_expire;
+        }
+
+        void set_convert_on_expire(bool convert) {
+            set_flag(order_flags::convert_on_expire, convert);
+        }
+
+        constexpr bool has_legacy_layout() const {
+            return flags & order_flags::legacy_layout;
+        }
 
         constexpr bool operator == (const order_t& o) const {
-            return trader == o.trader && value == o.value;
+            return trader == o.trader && amount == o.amount &&
+                is_sell_order() == o.is_sell_order();
         }
 
         constexpr bool operator != (const order_t& o) { return !(*this == o); }
         uint64_t get_id() const { return id; }
 
-        EOSLIB_SERIALIZE_DERIVED(order_t, index_queue_element, (id)(value)(trader)(expiration_time)(convert_on_expire))
+        template<typename DataStream>
+        friend DataStream& operator << (DataStream& ds, const order_t& o)
+        {
+            ds << static_cast<const index_queue_element&>(o);
+            ds << o.id;
+            ds << o.amount;
+            ds << o.trader;
+            ds << o.expiration_time;
+            ds << uint8_t(o.flags & ~order_flags::legacy_layout);
+            return ds;
+        }
+
+        template<typename DataStream>
+        friend DataStream& operator >> (DataStream& ds, order_t& o)
+        {
+            ds >> static_cast<index_queue_element&>(o);
+            ds >> o.id;
+
+            // Rows written before packed layout was introduced are read
+            // transparently and rewritten in packed layout on next modify.
+            constexpr auto legacy_tail_size = order_t::legacy_row_size - 2 * sizeof(uint64_t);
+            if(ds.remaining() == legacy_tail_size)
+            {
+                asset value;
+                bool convert_on_expire;
+                ds >> value;
+                ds >> o.trader;
+                ds >> o.expiration_time;
+                ds >> convert_on_expire;
+
+                o.flags = order_flags::legacy_layout;
+                o.set_value(value);
+                o.set_convert_on_expire(convert_on_expire);
+            }
+            else
+            {
+                ds >> o.amount;
+                ds >> o.trader;
+                ds >> o.expiration_time;
+                ds >> o.flags;
+            }
+            return ds;
+        }
+
+    private:
+        void set_flag(uint8_t flag, bool set) {
+            flags = set ? (flags | flag) : (flags & ~flag);
+        }
     };
 
 
     namespace detail {
+#ifdef PAGED_ORDER_BOOK
+        // Orders are stored in pages of order_page_capacity orders
+        static constexpr auto index_order_id = "orderpgmap"_n;
+        typedef paged_queue<"orderpages"_n, index_order_id, order_t,
+            const_mem_fun<order_t, order_id_t, &order_t::get_id>,
+            order_page_capacity
+        > order_queue_t;
+#elif defined(ORDER_BOOK_ID_PRIMARY)
+        // Orders are stored by order id, FIFO order is kept by secondary index on seq
+        static constexpr auto index_order_id = "id"_n;
+        typedef basic_index_queue<
+            key_policy::key_primary<index_order_id, const_mem_fun<order_t, order_id_t, &order_t::get_id>>,
+            "orderbook"_n, order_t
+        > order_queue_t;
+#else
         static constexpr auto index_order_id = "id"_n;
         typedef index_queue<"orderbook"_n, order_t,
             indexed_by<index_order_id, const_mem_fun<order_t, order_id_t, &order_t::get_id>>
         > order_queue_t;
+#endif
     }
 
+   /**
+    * Order book keeps it's aggregates (see book_stats_t) in sync with the book rows.
+    * Aggregates are loaded on first use and written back once when the book goes out of scope.
+    */
     struct order_book : public detail::order_queue_t
     {
         order_book(eosio::name owner, uint64_t scope) :
             detail::order_queue_t(owner, scope)
         {}
 
+        ~order_book()
+        {
+            if(stats_dirty_)
+            {
+                book_stats bs(get_code(), get_scope());
+                bs.set(*stats_, get_code());
+            }
+        }
+
         auto find(order_id_t id) const
         {
             return detail::order_queue_t::find<detail::index_order_id>(id);
@@ -69,6 +195,31 @@ namespace eosram::ds {
             return detail::order_queue_t::contains<detail::index_order_id>(id);
         }
 
+        /** Returns aggregates of the book */
+        const book_stats_t& stats() const
+        {
+            if(!stats_)
+            {
+                book_stats bs(get_code(), get_scope());
+                if(bs.exists()) {
+                    stats_ = bs.get();
+                }
+                else
+                {
+                    // Book which predates aggregates is counted once
+                    book_stats_t s;
+                    for(auto it = begin(); it != end(); ++it)
+                    {
+                        s.orders++;
+                        s.value += it->amount;
+                    }
+                    stats_ = s;
+                    stats_dirty_ = true;
+                }
+            }
+            return *stats_;
+        }
+
         void modify(order_t order, eosio::name payer)
         {
             auto it = find(order.id);
@@ -77,14 +228,15 @@ namespace eosram::ds {
 
         void modify(const_iterator it, order_t order, eosio::name payer)
         {
-            detail::order_queue_t::modify(it, std::move(order), payer);
+            update_stats(0, order.amount - it->amount);
+            detail::order_queue_t::modify(it, std::move(order), payer_of(payer));
         }
 
         void erase(order_id_t id)
         {
             auto it = find(id);
             if(it != end()) {
-                detail::order_queue_t::erase(it);
+                erase(it);
             }
         }
 
@@ -95,45 +247,97 @@ namespace eosram::ds {
 
         const_iterator erase(const_iterator it)
         {
+            update_stats(-1, -it->amount);
             return detail::order_queue_t::erase(it);
         }
 
         /** Makes new order entry at the back of the book */
         void emplace_order(eosio::name ram_payer, order_id_t order_id, eosio::name trader, const asset& value, uint32_t expiration_time, bool force_trade)
         {
-            order_t order;
-            order.id                = order_id;
-            order.value             = value;
-            order.trader            = trader;
-            order.expiration_time   = expiration_time;
-            order.convert_on_expire = force_trade;
+            order_t order(order_id, value, trader, expiration_time, force_trade);
+            update_stats(1, order.amount);
 
             // Push order to the back of the queue
-            this->push(std::move(order), ram_payer);
+            this->push(std::move(order), payer_of(ram_payer));
         }
-    };
 
-    struct buy_order_book : public order_book
-    {
-        buy_order_book(eosio::name owner) :
-            order_book(owner, get_scope())
-        {}
+    private:
+        eosio::name payer_of(eosio::name payer) const
+        {
+#ifdef PAGED_ORDER_BOOK
+            // Pages are shared between traders and are paid by the book owner
+            return payer == eosio::same_payer ? payer : get_code();
+#else
+            return payer;
+#endif
+        }
 
-        static uint64_t get_scope()
+        /** Must be called before the book rows are changed */
+        void update_stats(int64_t orders, int64_t value)
         {
-            return EOS_TOKEN_CONTRACT.value;
+            stats();
+            stats_->orders += orders;
+            stats_->value  += value;
+            stats_->version++;
+            stats_dirty_ = true;
         }
+
+    private:
+        mutable std::optional<book_stats_t> stats_;
+        mutable bool stats_dirty_ = false;
+    };
+
+    enum class order_side : uint8_t { buy, sell };
+
+   /**
+    * Compile-time properties of the order book side.
+    * Buy orders are in EOS token and are stored in eosio.token scope,
+    * sell orders are in RAM token and are stored in RAM token contract scope.
+    */
+    template<order_side Side>
+    struct order_side_traits;
+
+    template<>
+    struct order_side_traits<order_side::buy>
+    {
+        static constexpr order_side counter_side = order_side::sell;
+        static constexpr symbol value_symbol     = EOS_SYMBOL;
+        static constexpr uint64_t scope          = EOS_TOKEN_CONTRACT.value;
     };
 
-    struct sell_order_book : public order_book
+    template<>
+    struct order_side_traits<order_side::sell>
     {
-        sell_order_book(eosio::name owner) :
+        static constexpr order_side counter_side = order_side::buy;
+        static constexpr symbol value_symbol     = RAM_SYMBOL;
+        static constexpr uint64_t scope          = RAM_TOKEN_CONTRACT.value;
+    };
+
+    template<order_side Side>
+    using counter_side_traits = order_side_traits<order_side_traits<Side>::counter_side>;
+
+    template<order_side Side>
+    struct side_order_book : public order_book
+    {
+        using traits = order_side_traits<Side>;
+        static constexpr order_side side = Side;
+
+        side_order_book(eosio::name owner) :
             order_book(owner, get_scope())
         {}
 
-        static uint64_t get_scope()
+        static constexpr uint64_t get_scope()
         {
-            return RAM_TOKEN_CONTRACT.value;
+            return traits::scope;
+        }
+
+        /** Returns order's value in side's token */
+        static asset value_of(const order_t& order)
+        {
+            return asset(order.amount, traits::value_symbol);
         }
     };
+
+    using buy_order_book  = side_order_book<order_side::buy>;
+    using sell_order_book = side_order_book<order_side::sell>;
 }
\ No newline at end of file
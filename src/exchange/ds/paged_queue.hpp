@@ -0,0 +1,521 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <vector>
+
+#include "index_queue.hpp"
+
+namespace eosram::ds {
+    using eosio::multi_index;
+
+   /**
+    * FIFO queue which stores elements in fixed-capacity pages.
+    * Each page holds up to PageCapacity elements contiguously in one table row,
+    * and key -> page map is kept in separate table.
+    *
+    * Iterating the queue costs one DB read per page instead of one per element,
+    * finding element by key costs two DB reads (map and page).
+    *
+    * Erased element is only marked in page's erased mask. When page becomes at most
+    * half full, it's merged with the neighbouring page if both fit into one page,
+    * otherwise it's erased elements are compacted. Iterators remember the seq
+    * of their element and look it up again after pages were merged or compacted,
+    * so iterators to other than erased elements stay valid.
+    *
+    * Page primary key is the seq of the first element pushed to the page, so page
+    * of any element is the last page with primary key not greater than element's seq.
+    *
+    * Note: page row is billed to the payer of the last write to the page,
+    *       shared pages should therefore be paid by the contract account.
+    */
+    template<eosio::name::raw QueueName, eosio::name::raw MapName, typename ValueType, typename KeyExtractor, std::size_t PageCapacity>
+    class paged_queue
+    {
+        static_assert(std::is_base_of<index_queue_element, ValueType>::value,
+                "ValueType must inherit from index_queue_element!");
+        static_assert(PageCapacity > 0 && PageCapacity <= 64, "PageCapacity must be in range [1, 64]!");
+
+        struct page_t
+        {
+            uint64_t seq;
+            uint64_t erased = 0; // bit mask of erased elements
+            std::vector<ValueType> elements;
+
+            bool is_erased(uint32_t idx) const {
+                return (erased >> idx) & 1;
+            }
+
+            uint32_t live_count() const {
+                return elements.size() - __builtin_popcountll(erased);
+            }
+
+            /** Returns index of the first live element at or after idx, or elements.size() */
+            uint32_t next_live(uint32_t idx) const
+            {
+                while(idx < elements.size() && is_erased(idx)) {
+                    ++idx;
+                }
+                return idx;
+            }
+
+            /** Returns index of the last live element before idx, or -1 */
+            int32_t prev_live(int32_t idx) const
+            {
+                while(--idx >= 0 && is_erased(idx)) {}
+                return idx;
+            }
+
+            /** Removes erased elements */
+            void compact()
+            {
+                if(erased == 0) {
+                    return;
+                }
+
+                uint32_t n = 0;
+                for(uint32_t idx = 0; idx < elements.size(); idx++)
+                {
+                    if(!is_erased(idx)) {
+                        elements[n++] = std::move(elements[idx]);
+                    }
+                }
+                elements.resize(n);
+                erased = 0;
+            }
+
+            uint64_t primary_key() const { return seq; }
+            EOSLIB_SERIALIZE(page_t, (seq)(erased)(elements))
+        };
+
+        struct page_ref_t
+        {
+            uint64_t key;
+            uint64_t page;
+
+            uint64_t primary_key() const { return key; }
+            EOSLIB_SERIALIZE(page_ref_t, (key)(page))
+        };
+
+        using pages_t   = multi_index<QueueName, page_t>;
+        using map_t     = multi_index<MapName, page_ref_t>;
+        using page_it_t = typename pages_t::const_iterator;
+        static constexpr auto max_seq = std::numeric_limits<uint64_t>::max() - 1;
+
+        static uint64_t key_of(const ValueType& v) {
+            return KeyExtractor()(v);
+        }
+
+    public:
+        struct const_iterator : public std::iterator<std::bidirectional_iterator_tag, const ValueType>
+        {
+            friend bool operator == ( const const_iterator& a, const const_iterator& b )
+            {
+                return a.end_ == b.end_ && (a.end_ || a.seq_ == b.seq_);
+            }
+
+            friend bool operator != ( const const_iterator& a, const const_iterator& b )
+            {
+                return !(a == b);
+            }
+
+            const ValueType& operator*() const
+            {
+                sync();
+                return it_->elements.at(idx_);
+            }
+
+            const ValueType* operator->() const
+            {
+                return &(**this);
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator result(*this);
+                ++(*this);
+                return result;
+            }
+
+            const_iterator operator--(int)
+            {
+                const_iterator result(*this);
+                --(*this);
+                return result;
+            }
+
+            const_iterator& operator++()
+            {
+                sync();
+                idx_ = it_->next_live(idx_ + 1);
+                if(idx_ >= it_->elements.size())
+                {
+                    ++it_;
+                    idx_ = 0;
+                    if(it_ == q_->pages_.end())
+                    {
+                        end_ = true;
+                        return *this;
+                    }
+                    idx_ = it_->next_live(0);
+                }
+                seq_ = it_->elements[idx_].seq;
+                return *this;
+            }
+
+            const_iterator& operator--()
+            {
+                sync();
+                int32_t idx = -1;
+                if(!end_) {
+                    idx = it_->prev_live(idx_);
+                }
+
+                if(idx < 0)
+                {
+                    --it_;
+                    idx = it_->prev_live(it_->elements.size());
+                }
+
+                end_ = false;
+                idx_ = static_cast<uint32_t>(idx);
+                seq_ = it_->elements[idx_].seq;
+                return *this;
+            }
+
+            uint64_t internal_idx() const
+            {
+                return (*this)->seq;
+            }
+
+        private:
+            // Every stored page has at least one live element
+            const_iterator(const paged_queue& q, page_it_t it, uint32_t idx) :
+                q_(&q),
+                it_(std::move(it)),
+                idx_(idx),
+                end_(it_ == q.pages_.end()),
+                epoch_(q.epoch_)
+            {
+                if(!end_) {
+                    seq_ = it_->elements[idx_].seq;
+                }
+            }
+
+            /** Looks up element's position again if pages were rewritten since it was taken */
+            void sync() const
+            {
+                if(epoch_ == q_->epoch_) {
+                    return;
+                }
+
+                epoch_ = q_->epoch_;
+                if(end_) {
+                    it_ = q_->pages_.end();
+                    return;
+                }
+
+                auto pit = q_->page_of(seq_);
+                uint32_t idx = pit->next_live(0);
+                while(idx < pit->elements.size() && pit->elements[idx].seq < seq_) {
+                    idx = pit->next_live(idx + 1);
+                }
+
+                eosio_assert(idx < pit->elements.size() && pit->elements[idx].seq == seq_,
+                    "paged_queue: iterator points to erased element!");
+                it_  = pit;
+                idx_ = idx;
+            }
+
+        private:
+            const paged_queue* q_;
+            mutable page_it_t it_;
+            mutable uint32_t idx_;
+            uint64_t seq_ = 0;
+            bool end_;
+            mutable uint64_t epoch_;
+            friend class paged_queue;
+        };
+
+
+        // Constructor
+        paged_queue(eosio::name code, uint64_t scope) :
+            pages_(code, scope),
+            map_(code, scope)
+        {}
+
+        // Iterators refer to this queue
+        paged_queue(const paged_queue&) = delete;
+        paged_queue& operator = (const paged_queue&) = delete;
+
+        const_iterator begin() const
+        {
+            return make_iterator(pages_.begin());
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(*this, pages_.end(), 0);
+        }
+
+        template<eosio::name::raw IndexName, typename Key>
+        bool contains(const Key& key) const
+        {
+            static_assert(IndexName == MapName, "paged_queue: elements can be found only by the page map key!");
+            return map_.find(static_cast<uint64_t>(key)) != map_.end();
+        }
+
+        template<typename ...Args>
+        void emplace(eosio::name payer, Args&& ... args)
+        {
+            push(ValueType{ std::forward<Args>(args)... }, payer);
+        }
+
+        bool empty() const
+        {
+            return pages_.begin() == pages_.end();
+        }
+
+        /** Erases element, iterators to other elements stay valid */
+        const_iterator erase(const_iterator it)
+        {
+            eosio_assert(it != end(), "Cannot erase paged_queue element, invalid iterator!");
+            map_.erase(map_.get(key_of(*it), "paged_queue: element key not found in page map!"));
+
+            auto next = std::next(it);
+            auto pit  = it.it_;
+            if(pit->live_count() == 1)
+            {
+                // Only iterators to the erased element point to the page
+                pages_.erase(pit);
+                return next;
+            }
+
+            const auto idx = it.idx_;
+            pages_.modify(pit, eosio::same_payer, [&](auto& p) {
+                p.erased |= uint64_t(1) << idx;
+            });
+
+            if(pit->live_count() * 2 <= PageCapacity) {
+                shrink(pit);
+            }
+            return next;
+        }
+
+        template<eosio::name::raw IndexName, typename Key>
+        const_iterator find(const Key& k) const
+        {
+            static_assert(IndexName == MapName, "paged_queue: elements can be found only by the page map key!");
+            const auto key = static_cast<uint64_t>(k);
+            auto ref = map_.find(key);
+            if(ref == map_.end()) {
+                return end();
+            }
+
+            auto pit = pages_.find(ref->page);
+            eosio_assert(pit != pages_.end(), "paged_queue: page map points to non-existing page!");
+
+            const auto& e = pit->elements;
+            for(uint32_t idx = 0; idx < e.size(); idx++)
+            {
+                if(!pit->is_erased(idx) && key_of(e[idx]) == key) {
+                    return const_iterator(*this, pit, idx);
+                }
+            }
+
+            eosio_assert(false, "paged_queue: element not found in mapped page!");
+            return end();
+        }
+
+        /** Returns iterator to the first element with seq not less than given seq */
+        const_iterator lower_bound(uint64_t seq) const
+        {
+            if(empty()) {
+                return end();
+            }
+
+            auto pit = page_of(seq);
+            uint32_t idx = pit->next_live(0);
+            while(idx < pit->elements.size() && pit->elements[idx].seq < seq) {
+                idx = pit->next_live(idx + 1);
+            }
+
+            // Remaining elements of the page are erased, next page starts at greater seq
+            if(idx >= pit->elements.size()) {
+                return make_iterator(std::next(pit));
+            }
+            return const_iterator(*this, pit, idx);
+        }
+
+        eosio::name get_code() const
+        {
+            return pages_.get_code();
+        }
+
+        uint64_t get_scope() const
+        {
+            return pages_.get_scope();
+        }
+
+        void modify(const_iterator it, ValueType value, eosio::name payer)
+        {
+            eosio_assert(it != end(), "Cannot modify paged_queue element, invalid iterator!");
+            eosio_assert(key_of(value) == key_of(*it), "Cannot modify paged_queue element's key!");
+
+            const auto idx = it.idx_;
+            pages_.modify(it.it_, payer, [&](auto& p) {
+                auto seq = p.elements[idx].seq;
+                p.elements[idx] = std::move(value);
+                p.elements[idx].seq = seq;
+            });
+        }
+
+        std::optional<ValueType> pop()
+        {
+            std::optional<ValueType> v;
+            auto it = begin();
+            if(it != end())
+            {
+                v = *it;
+                erase(it);
+            }
+
+            return v;
+        }
+
+        /** Pushes element to the back of the queue, erased elements of the last page are compacted */
+        void push(ValueType value, eosio::name payer)
+        {
+            value.seq = 0;
+            uint64_t page_seq = 0;
+            bool new_page = true;
+
+            auto pit = pages_.rbegin();
+            if(pit != pages_.rend())
+            {
+                value.seq = pit->elements.back().seq + 1;
+                eosio_assert(value.seq < max_seq, "Cannot push element to queue, seq is at max limit");
+
+                new_page = pit->live_count() >= PageCapacity;
+                page_seq = new_page ? value.seq : pit->seq;
+            }
+
+            map_.emplace(payer, [&](auto& ref) {
+                ref.key  = key_of(value);
+                ref.page = page_seq;
+            });
+
+            if(!new_page)
+            {
+                if(pit->erased != 0) {
+                    epoch_++;
+                }
+
+                pages_.modify(pages_.find(page_seq), payer, [&](auto& p) {
+                    p.compact();
+                    p.elements.push_back(std::move(value));
+                });
+            }
+            else
+            {
+                pages_.emplace(payer, [&](auto& p) {
+                    p.seq = page_seq;
+                    p.elements.reserve(PageCapacity);
+                    p.elements.push_back(std::move(value));
+                });
+            }
+        }
+
+        const_iterator top() const
+        {
+            return begin();
+        }
+
+    private:
+        const_iterator make_iterator(page_it_t pit) const
+        {
+            const uint32_t idx = pit != pages_.end() ? pit->next_live(0) : 0;
+            return const_iterator(*this, std::move(pit), idx);
+        }
+
+        /** Returns page which holds element with given seq, queue must not be empty */
+        page_it_t page_of(uint64_t seq) const
+        {
+            auto pit = pages_.upper_bound(seq);
+            if(pit != pages_.begin()) {
+                --pit;
+            }
+            return pit;
+        }
+
+       /**
+        * Merges page with the previous or the next page if they fit into one page,
+        * otherwise compacts page's erased elements.
+        */
+        void shrink(page_it_t pit)
+        {
+            const auto live = pit->live_count();
+            if(pit != pages_.begin())
+            {
+                auto prev = std::prev(pit);
+                if(prev->live_count() + live <= PageCapacity)
+                {
+                    merge(prev, pit);
+                    return;
+                }
+            }
+
+            auto next = std::next(pit);
+            if(next != pages_.end() && next->live_count() + live <= PageCapacity)
+            {
+                merge(pit, next);
+                return;
+            }
+
+            epoch_++;
+            pages_.modify(pit, eosio::same_payer, [&](auto& p) {
+                p.compact();
+            });
+        }
+
+        /** Moves elements of page src to the end of the preceding page dst and erases src */
+        void merge(page_it_t dst, page_it_t src)
+        {
+            epoch_++;
+            const auto dst_seq = dst->seq;
+            for(uint32_t idx = 0; idx < src->elements.size(); idx++)
+            {
+                if(!src->is_erased(idx))
+                {
+                    const auto& ref = map_.get(key_of(src->elements[idx]), "paged_queue: element key not found in page map!");
+                    map_.modify(ref, eosio::same_payer, [&](auto& r) {
+                        r.page = dst_seq;
+                    });
+                }
+            }
+
+            pages_.modify(dst, eosio::same_payer, [&](auto& p) {
+                p.compact();
+                for(uint32_t idx = 0; idx < src->elements.size(); idx++)
+                {
+                    if(!src->is_erased(idx)) {
+                        p.elements.push_back(src->elements[idx]);
+                    }
+                }
+            });
+            pages_.erase(src);
+        }
+
+    private:
+        pages_t pages_;
+        map_t map_;
+        uint64_t epoch_ = 0; // incremented when elements are moved within or between pages
+    };
+}
@@ -1,35 +1,98 @@
 #pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
 #include <eosiolib/name.hpp>
-#include <string>
 
-#include "index_queue.hpp"
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <vector>
 
 namespace eosram::ds {
-    struct pending_trfx_recip_t : public index_queue_element
+    using namespace eosio;
+
+   /**
+    * Pending payout of convert-on-expire sell orders of one recipient.
+    * Transfer memo is generated at payout time from the stored fields.
+    */
+    struct pending_trfx_recip_t
     {
         eosio::name name;
-        std::string trfx_memo;
+        int64_t ram;    // sold RAM bytes
+        int64_t price;  // RAM price per KiB in EOS at the time of the sale, weighted by sold RAM
 
-        pending_trfx_recip_t() = default;
-        pending_trfx_recip_t(eosio::name n, std::string m) :
-            name(n),
-            trfx_memo(std::move(m))
-        {}
- 
-        EOSLIB_SERIALIZE_DERIVED(pending_trfx_recip_t,
-            index_queue_element, (name)(trfx_memo))
+        /** Adds sold RAM, price becomes volume-weighted price of both sales */
+        void merge(int64_t r, int64_t p)
+        {
+            price = static_cast<int64_t>((int128_t(price) * ram + int128_t(p) * r) / (ram + r));
+            ram  += r;
+        }
+
+        EOSLIB_SERIALIZE(pending_trfx_recip_t, (name)(ram)(price))
+    };
+
+   /**
+    * RAM sold on rammarket at the end of exchange action, waiting for sale proceeds.
+    * Replaces legacy "pendingtxfr" queue, which stored one memo row per order
+    * and is always drained within the transaction that filled it.
+    */
+    struct [[eosio::table("pendingsales"), eosio::contract("eosram.exchange")]]
+    pending_sale_t
+    {
+        uint64_t id;
+        std::vector<pending_trfx_recip_t> recipients;
+
+        uint64_t primary_key() const { return id; }
+
+        EOSLIB_SERIALIZE(pending_sale_t, (id)(recipients))
     };
 
-    struct pending_trfx_queue_t : public 
-        index_queue<"pendingtxfr"_n, pending_trfx_recip_t>
+   /**
+    * Inline actions run depth first, so proceeds of nested exchange action's sale
+    * arrive before proceeds of the outer action's sale, sales are therefore paid
+    * from the last recorded one.
+    */
+    struct pending_sales_t : public multi_index<"pendingsales"_n, pending_sale_t>
     {
-        pending_trfx_queue_t(eosio::name owner) : 
-            index_queue(owner, owner.value)
+        pending_sales_t(eosio::name owner) :
+            multi_index(owner, owner.value)
         {}
 
-        inline void push(eosio::name recip, std::string trfx_memo, eosio::name ram_payer)
+        void push(std::vector<pending_trfx_recip_t> recipients, eosio::name ram_payer)
         {
-            index_queue::push(pending_trfx_recip_t(recip, std::move(trfx_memo)), ram_payer);
+            auto last = rbegin();
+            const uint64_t id = last != rend() ? last->id + 1 : 0;
+            emplace(ram_payer, [&](auto& s) {
+                s.id = id;
+                s.recipients = std::move(recipients);
+            });
+        }
+
+        /** Pops payouts of the last recorded sale */
+        std::optional<std::vector<pending_trfx_recip_t>> pop_last()
+        {
+            auto last = rbegin();
+            if(last == rend()) {
+                return std::nullopt;
+            }
+
+            auto recipients = last->recipients;
+            erase(std::prev(last.base()));
+            return recipients;
         }
     };
+
+    /** Adds payout to recipient's pending payout of the current sale */
+    inline void add_pending_payout(std::vector<pending_trfx_recip_t>& recipients, eosio::name recip, int64_t ram, int64_t price)
+    {
+        auto it = std::find_if(recipients.begin(), recipients.end(), [&](const auto& r) {
+            return r.name == recip;
+        });
+
+        if(it != recipients.end()) {
+            it->merge(ram, price);
+        } else {
+            recipients.push_back({ recip, ram, price });
+        }
+    }
 }
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+
+#include <limits>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <vector>
+
+#include "index_queue.hpp"
+
+namespace eosram::ds {
+    using eosio::multi_index;
+
+    /** Makes composite 128-bit priority key, lower key has higher priority. */
+    inline constexpr uint128_t make_priority(uint64_t major, uint64_t minor = 0ULL) {
+        return (static_cast<uint128_t>(major) << 64) | minor;
+    }
+
+   /**
+    * Priority queue stored in multi_index table.
+    * Elements are ordered by 128-bit priority key extracted by KeyExtractor (lowest first),
+    * elements with equal priority are ordered by insertion (FIFO).
+    * Push and pop-min are O(log n).
+    *
+    * KeyExtractor must be callable as uint128_t(const ValueType&).
+    */
+    template<eosio::name::raw Name, typename ValueType, typename KeyExtractor, typename... Indices>
+    class priority_index
+    {
+        static_assert(std::is_base_of<index_queue_element, ValueType>::value,
+                "ValueType must inherit from index_queue_element!");
+
+        static constexpr eosio::name::raw index_priority = "priority"_n;
+
+        struct pe_t : ValueType
+        {
+            operator ValueType& () { return *this; };
+            operator const ValueType& () const { return *this; };
+            uint64_t primary_key() const { return index_queue_element::seq; }
+            uint128_t get_priority() const { return KeyExtractor()(static_cast<const ValueType&>(*this)); }
+
+            template<typename DataStream>
+            friend DataStream& operator << ( DataStream& ds, const pe_t& t )
+            {
+                ds << static_cast<const ValueType&>(t);
+                return ds;
+            }
+
+            template<typename DataStream>
+            friend DataStream& operator >> ( DataStream& ds, pe_t& t )
+            {
+                ds >> static_cast<ValueType&>(t);
+                return ds;
+            }
+        };
+
+        using pi_t = multi_index<Name, pe_t,
+            indexed_by<index_priority, const_mem_fun<pe_t, uint128_t, &pe_t::get_priority>>,
+            Indices...
+        >;
+
+        using priority_idx_t = decltype(std::declval<pi_t&>().template get_index<index_priority>());
+
+    public:
+        struct const_iterator : public std::iterator<std::bidirectional_iterator_tag, const ValueType>
+        {
+            friend bool operator == ( const const_iterator& a, const const_iterator& b )
+            {
+                return a.it_ == b.it_;
+            }
+
+            friend bool operator != ( const const_iterator& a, const const_iterator& b )
+            {
+                return a.it_ != b.it_;
+            }
+
+            const ValueType& operator*() const
+            {
+                return *it_;
+            }
+
+            const ValueType* operator->() const
+            {
+                return &(*it_);
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator result(*this);
+                ++(*this);
+                return result;
+            }
+
+            const_iterator operator--(int)
+            {
+                const_iterator result(*this);
+                --(*this);
+                return result;
+            }
+
+            const_iterator& operator++()
+            {
+                it_++;
+                return *this;
+            }
+
+            const_iterator& operator--()
+            {
+                it_--;
+                return *this;
+            }
+
+            uint64_t internal_idx() const
+            {
+                return it_->seq;
+            }
+
+        private:
+            using pi_it_t = typename priority_idx_t::const_iterator;
+            const_iterator(pi_it_t it) :
+                it_(std::move(it))
+            {}
+
+            operator const pi_it_t& () const
+            {
+                return it_;
+            }
+
+        private:
+            pi_it_t it_;
+            friend class priority_index;
+        };
+
+
+        // Constructor
+        priority_index(eosio::name code, uint64_t scope) :
+            pi_(code, scope),
+            pidx_(pi_.template get_index<index_priority>())
+        {}
+
+        // Priority index refers to this object's table
+        priority_index(const priority_index&) = delete;
+        priority_index& operator = (const priority_index&) = delete;
+
+        const_iterator begin() const
+        {
+            return pidx_.begin();
+        }
+
+        const_iterator end() const
+        {
+            return pidx_.end();
+        }
+
+        template<eosio::name::raw IndexName, typename Key>
+        bool contains(const Key& key) const
+        {
+            return find<IndexName>(key) != end();
+        }
+
+        template<typename ...Args>
+        void emplace(eosio::name payer, Args&& ... args)
+        {
+            push(ValueType{ std::forward<Args>(args)... }, payer);
+        }
+
+        bool empty() const
+        {
+            return pi_.begin() == pi_.end();
+        }
+
+        const_iterator erase(const_iterator it)
+        {
+            eosio_assert(it != end(), "Cannot erase priority_index element, invalid iterator!");
+            return pidx_.erase(it);
+        }
+
+        template<eosio::name::raw IndexName, typename Key>
+        const_iterator find(const Key& k) const
+        {
+            auto idx = pi_.template get_index<IndexName>();
+            auto it = idx.find(k);
+            if(it != idx.end()) {
+                return pidx_.iterator_to(*it);
+            }
+            return end();
+        }
+
+        /** Returns iterator to the first element with priority not less than given priority */
+        const_iterator lower_bound(uint128_t priority) const
+        {
+            return pidx_.lower_bound(priority);
+        }
+
+        eosio::name get_code() const
+        {
+            return pi_.get_code();
+        }
+
+        uint64_t get_scope() const
+        {
+            return pi_.get_scope();
+        }
+
+        void modify(const_iterator it, ValueType value, eosio::name payer)
+        {
+            eosio_assert(it != end(), "Cannot modify priority_index element, invalid iterator!");
+            pidx_.modify(it, payer, [&](auto& pe) {
+                auto seq = pe.seq;
+                pe = static_cast<pe_t&&>(std::move(value));
+                pe.seq = seq;
+            });
+        }
+
+        /** Removes and returns element with the highest priority */
+        std::optional<ValueType> pop()
+        {
+            std::optional<ValueType> v;
+            auto it = begin();
+            if(it != end())
+            {
+                v = *it;
+                erase(it);
+            }
+
+            return v;
+        }
+
+       /**
+        * Removes and returns up to limit elements with the highest
+        * priority for which predicate returns true.
+        * Stops at the first element for which predicate returns false.
+        */
+        template<typename Predicate>
+        std::vector<ValueType> pop_while(Predicate&& pred, uint32_t limit = std::numeric_limits<uint32_t>::max())
+        {
+            std::vector<ValueType> v;
+            auto it = begin();
+            while(limit --> 0 && it != end() && pred(*it))
+            {
+                v.push_back(*it);
+                it = erase(it);
+            }
+
+            return v;
+        }
+
+        void push(ValueType value, eosio::name payer)
+        {
+            const auto seq = pi_.available_primary_key();
+            eosio_assert(seq < std::numeric_limits<uint64_t>::max() - 1, "Cannot push element to priority_index, seq is at max limit");
+
+            pi_.emplace(payer, [&](auto& pe) {
+                pe = static_cast<pe_t&&>(std::move(value));
+                pe.seq = seq;
+            });
+        }
+
+        const_iterator top() const
+        {
+            return begin();
+        }
+
+    private:
+        mutable pi_t pi_;
+        mutable priority_idx_t pidx_;
+    };
+}
@@ -1,9 +1,41 @@
-// Note: source copied from eosio.contracts v1.3
+// Note: source copied from eosio.contracts v1.3,
+//       conversions of 50/50 relay are computed by integer emulation (see bancor.hpp).
 #include "ram_exchange_state.hpp"
+#include "bancor.hpp"
 #include <cmath>
 
 namespace eosiosystem {
+   namespace bancor = eosram::ds::bancor;
+
    asset exchange_state::convert_to_exchange( connector& c, asset in ) {
+      if( c.weight != 0.5 || !bancor::in_domain( supply.amount, c.balance.amount, in.amount ) ) {
+         return convert_to_exchange_real( c, in );
+      }
+
+      int64_t issued = bancor::to_exchange( supply.amount, c.balance.amount, in.amount );
+
+      supply.amount += issued;
+      c.balance.amount += in.amount;
+
+      return asset( issued, supply.symbol );
+   }
+
+   asset exchange_state::convert_from_exchange( connector& c, asset in ) {
+      eosio_assert( in.symbol== supply.symbol, "unexpected asset symbol input" );
+      if( c.weight != 0.5 || !bancor::in_domain( supply.amount, c.balance.amount, in.amount ) ||
+          in.amount >= supply.amount - in.amount ) {
+         return convert_from_exchange_real( c, in );
+      }
+
+      int64_t out = bancor::from_exchange( supply.amount, c.balance.amount, in.amount );
+
+      supply.amount -= in.amount;
+      c.balance.amount -= out;
+
+      return asset( out, c.balance.symbol );
+   }
+
+   asset exchange_state::convert_to_exchange_real( connector& c, asset in ) {
 
       real_type R(supply.amount);
       real_type C(c.balance.amount+in.amount);
@@ -20,7 +52,7 @@ namespace eosiosystem {
       return asset( issued, supply.symbol );
    }
 
-   asset exchange_state::convert_from_exchange( connector& c, asset in ) {
+   asset exchange_state::convert_from_exchange_real( connector& c, asset in ) {
       eosio_assert( in.symbol== supply.symbol, "unexpected asset symbol input" );
 
       real_type R(supply.amount - in.amount);
@@ -46,6 +78,14 @@ namespace eosiosystem {
    }
 
    asset exchange_state::convert( asset from, const symbol& to ) {
+      return convert( from, to, &exchange_state::convert_to_exchange, &exchange_state::convert_from_exchange );
+   }
+
+   asset exchange_state::convert_real( asset from, const symbol& to ) {
+      return convert( from, to, &exchange_state::convert_to_exchange_real, &exchange_state::convert_from_exchange_real );
+   }
+
+   asset exchange_state::convert( asset from, const symbol& to, convert_fn to_exchange, convert_fn from_exchange ) {
       auto sell_symbol  = from.symbol;
       auto ex_symbol    = supply.symbol;
       auto base_symbol  = base.balance.symbol;
@@ -58,24 +98,24 @@ namespace eosiosystem {
 
       if( sell_symbol != ex_symbol ) {
          if( sell_symbol == base_symbol ) {
-            from = convert_to_exchange( base, from );
+            from = (this->*to_exchange)( base, from );
          } else if( sell_symbol == quote_symbol ) {
-            from = convert_to_exchange( quote, from );
+            from = (this->*to_exchange)( quote, from );
          } else { 
             eosio_assert( false, "invalid sell" );
          }
       } else {
          if( to == base_symbol ) {
-            from = convert_from_exchange( base, from ); 
+            from = (this->*from_exchange)( base, from ); 
          } else if( to == quote_symbol ) {
-            from = convert_from_exchange( quote, from ); 
+            from = (this->*from_exchange)( quote, from ); 
          } else {
             eosio_assert( false, "invalid conversion" );
          }
       }
 
       if( to != from.symbol )
-         return convert( from, to );
+         return convert( from, to, to_exchange, from_exchange );
 
       return from;
    }
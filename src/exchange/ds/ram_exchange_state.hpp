@@ -35,6 +35,17 @@ namespace eosiosystem {
       asset convert_from_exchange( connector& c, asset in );
       asset convert( asset from, const symbol& to );
 
+      /** Original double precision conversions of the system contract */
+      asset convert_to_exchange_real( connector& c, asset in );
+      asset convert_from_exchange_real( connector& c, asset in );
+      asset convert_real( asset from, const symbol& to );
+
+   private:
+      typedef asset (exchange_state::*convert_fn)( connector&, asset );
+      asset convert( asset from, const symbol& to, convert_fn to_exchange, convert_fn from_exchange );
+
+   public:
+
       EOSLIB_SERIALIZE( exchange_state, (supply)(base)(quote) )
    };
 
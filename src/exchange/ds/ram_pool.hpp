@@ -0,0 +1,100 @@
+#pragma once
+#include <eosiolib/asset.hpp>
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+#include "ram_market.hpp"
+#include "../constants.hpp"
+#include "../log.hpp"
+#include "../trade_tools.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    ram_pool_t
+    {
+        uint64_t bytes   = 0;                     // RAM bytes bought but not yet allocated to token balances
+        asset    funds   = asset(0, EOS_SYMBOL);  // EOS collected from transfer fees, not yet spent on RAM
+        uint64_t deficit = 0;                     // bytes allocated while the reserve was empty, covered by the next refill
+
+        EOSLIB_SERIALIZE(ram_pool_t, (bytes)(funds)(deficit))
+    };
+
+   /**
+    * Pre-funded RAM reserve used to open token balances for new holders.
+    * Token transfer fees are deposited into the pool and spent on system RAM
+    * in bulk once the reserve drops below the low watermark and the funds can
+    * buy at least the watermark, instead of buying RAM on the system market for every new holder.
+    */
+    struct ram_pool : public singleton<"rampool"_n, ram_pool_t>
+    {
+        ram_pool(name owner) :
+            singleton(owner, owner.value),
+            owner_(owner)
+        {}
+
+        /** Deposits EOS into the pool */
+        void deposit(const asset& funds)
+        {
+            eosio_assert(funds.symbol == EOS_SYMBOL, "ram_pool: funds must be in EOS!");
+            auto s = get_or_default();
+            s.funds += funds;
+            set(s, owner_);
+        }
+
+        /** Deposits RAM bytes already owned by the pool owner (e.g. backing of burned RAM token) */
+        void deposit_bytes(uint64_t bytes)
+        {
+            auto s = get_or_default();
+            s.bytes += bytes;
+            set(s, owner_);
+        }
+
+       /**
+        * Allocates bytes from the pool.
+        * If the reserve would fall below the low watermark, all deposited funds are spent
+        * on RAM in one buyram action once they can buy at least watermark bytes,
+        * or immediately if the reserve can't cover the allocation.
+        * Bytes which can't be covered are recorded as deficit and deducted from the next refill.
+        *
+        * Note: pool only keeps book-keeping of the reserve,
+        *       the actual RAM usage is enforced by the system contract.
+        */
+        void allocate(uint64_t bytes, uint64_t watermark)
+        {
+            auto s = get_or_default();
+            const uint64_t needed = bytes + s.deficit;
+            if(s.bytes < needed + watermark && s.funds.amount > 0)
+            {
+                ram_market rm;
+                auto out_eos = deduct_fee(s.funds, ram_market_fee).value;
+                const uint64_t out_bytes = rm.convert_to_ram(out_eos).amount;
+                if(s.bytes < needed || out_bytes >= watermark)
+                {
+                    LOG_DEBUG("ram_pool: refilling RAM reserve with: %", s.funds);
+
+                    s.bytes += out_bytes;
+                    rm.buyram(owner_, owner_, s.funds);
+                    s.funds.amount = 0;
+                }
+            }
+
+            if(s.bytes >= needed)
+            {
+                s.bytes  -= needed;
+                s.deficit = 0;
+            }
+            else
+            {
+                s.deficit = needed - s.bytes;
+                s.bytes   = 0;
+            }
+            set(s, owner_);
+        }
+
+    private:
+        name owner_;
+    };
+}
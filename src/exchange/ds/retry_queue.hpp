@@ -0,0 +1,79 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+
+#include <vector>
+
+#include "priority_index.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * Failed deferred transaction waiting to be resent.
+    * After the transaction is resent, element is kept in flight until
+    * in_flight_timeout passes, so the attempt count survives if it fails again.
+    */
+    struct [[eosio::table("retries"), eosio::contract("eosram.exchange")]] retry_t : public index_queue_element
+    {
+        uint128_t sender_id;
+        name      payer;
+        uint32_t  attempts     = 0;
+        uint32_t  next_attempt = 0; // time of the next resend, or time when in flight element is dropped
+        bool      in_flight    = false;
+        std::vector<char> trx;      // packed failed transaction
+
+        uint128_t get_sender_id() const { return sender_id; }
+
+        EOSLIB_SERIALIZE_DERIVED(retry_t, index_queue_element,
+            (sender_id)(payer)(attempts)(next_attempt)(in_flight)(trx))
+    };
+
+    struct retry_priority
+    {
+        uint128_t operator()(const retry_t& r) const {
+            return make_priority(r.next_attempt);
+        }
+    };
+
+    static constexpr auto index_sender_id = "senderid"_n;
+    typedef priority_index<"retries"_n,
+        retry_t,
+        retry_priority,
+        indexed_by<index_sender_id, const_mem_fun<retry_t, uint128_t, &retry_t::get_sender_id>>
+    > retry_queue_base_t;
+
+    struct retry_queue : public retry_queue_base_t
+    {
+        retry_queue(name owner) :
+            retry_queue_base_t(owner, owner.value)
+        {}
+
+        auto find(uint128_t sender_id) const {
+            return retry_queue_base_t::find<index_sender_id>(sender_id);
+        }
+    };
+
+    /** Transaction which failed retry_max_attempts times */
+    struct [[eosio::table("deadletters"), eosio::contract("eosram.exchange")]]
+    dead_letter_t
+    {
+        uint64_t  id;
+        uint128_t sender_id;
+        uint32_t  attempts;
+        uint32_t  failed_at;
+        std::vector<char> trx;
+
+        uint64_t primary_key() const { return id; }
+
+        EOSLIB_SERIALIZE(dead_letter_t, (id)(sender_id)(attempts)(failed_at)(trx))
+    };
+
+    struct dead_letters : public multi_index<"deadletters"_n, dead_letter_t>
+    {
+        dead_letters(name owner) :
+            multi_index(owner, owner.value)
+        {}
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+#include <algorithm>
+
+#include "../constants.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+    /** Outcome of single execution pass of the matcher */
+    struct pass_stats_t
+    {
+        uint32_t fills   = 0;     // number of matched counter orders
+        bool     backlog = false; // counter orders were left unprocessed due to execution limit
+    };
+
+   /**
+    * Signals observed by the execution scheduler of orders in one order book.
+    * Stored in the book's scope (like book_stats_t), updated after each execution pass
+    * of book's order and on failed deferred transaction of book's order.
+    */
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    sched_state_t
+    {
+        uint32_t batch_size   = 0;     // current execution limit, 0 if not yet adapted
+        uint32_t idle_passes  = 0;     // consecutive passes without any fill
+        uint32_t failures     = 0;     // failed deferred transactions in current failure window
+        uint32_t last_failure = 0;     // time of the last failure
+        bool     backlog      = false; // last pass left counter orders unprocessed
+
+        bool has_recent_failures(uint32_t time) const {
+            return failures > 0 && time - last_failure < sched_failure_window;
+        }
+
+        void record_failure(uint32_t time)
+        {
+            if(!has_recent_failures(time)) {
+                failures = 0;
+            }
+            failures = std::min(failures + 1, sched_max_backoff_shift);
+            last_failure = time;
+        }
+
+        constexpr bool operator == (const sched_state_t& s) const {
+            return batch_size == s.batch_size && idle_passes == s.idle_passes &&
+                failures == s.failures && last_failure == s.last_failure && backlog == s.backlog;
+        }
+
+        constexpr bool operator != (const sched_state_t& s) const { return !(*this == s); }
+
+        EOSLIB_SERIALIZE(sched_state_t, (batch_size)(idle_passes)(failures)(last_failure)(backlog))
+    };
+
+    struct sched_state : public singleton<"schedstate"_n, sched_state_t>
+    {
+        sched_state(name owner, uint64_t book_scope) :
+            singleton(owner, book_scope)
+        {}
+    };
+}
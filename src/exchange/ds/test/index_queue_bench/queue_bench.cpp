@@ -0,0 +1,123 @@
+#include <eosiolib/eosio.hpp>
+
+#include "../../index_queue.hpp"
+#include "../../priority_index.hpp"
+
+
+using namespace eosram::ds;
+using namespace eosio;
+
+/**
+ * Compares index_queue key policies and priority_index under order book like workload.
+ * Each action runs the same workload on one layout, compare
+ * action's elapsed/billed CPU time in transaction traces e.g.:
+ *   cleos push action <acc> benchseq '[100]' -p <acc> --json | jq '.processed.action_traces[0].elapsed'
+ *   cleos push action <acc> benchid  '[100]' -p <acc> --json | jq '.processed.action_traces[0].elapsed'
+ *   cleos push action <acc> benchprio '[100]' -p <acc> --json | jq '.processed.action_traces[0].elapsed'
+ *
+ * DB calls per operation (multi_index level):
+ *   op                 seq_primary                          key_primary                          priority_index
+ *   find by key        idx64_find_secondary + db_find/get   db_find/get (+ idx64_find_primary    idx64_find_secondary + db_find/get + idx128_find_primary
+ *                                                           when iterator is moved or erased)
+ *   modify/erase       db_update/remove + idx64 update      db_update/remove + idx64 update      db_update/remove + idx64 and idx128 update
+ *   pop (FIFO/min)     db_lowerbound/get                    idx64_lowerbound + db_find/get       idx128_lowerbound + db_find/get
+ */
+class queue_bench : public eosio::contract
+{
+    struct queue_value : index_queue_element
+    {
+        uint64_t key;
+        int64_t value;
+
+        queue_value() = default;
+        queue_value(uint64_t k, int64_t v ) : key(k), value(v) {}
+        uint64_t get_key() const { return key; }
+
+        EOSLIB_SERIALIZE_DERIVED(queue_value, index_queue_element, (key)(value))
+    };
+
+    static constexpr auto index_key = "key"_n;
+    typedef index_queue<"benchseq"_n,
+        queue_value,
+        indexed_by<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>
+    > seq_q_t;
+
+    typedef basic_index_queue<
+        key_policy::key_primary<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>,
+        "benchid"_n, queue_value
+    > id_q_t;
+
+    struct key_priority
+    {
+        uint128_t operator()(const queue_value& qv) const {
+            return make_priority(qv.key);
+        }
+    };
+
+    typedef priority_index<"benchprio"_n,
+        queue_value,
+        key_priority,
+        indexed_by<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>
+    > prio_q_t;
+
+public:
+    using eosio::contract::contract;
+
+    /// @abi action
+    void benchseq(uint32_t n)
+    {
+        seq_q_t q(get_self(), get_self().value);
+        run(q, n);
+    }
+
+    /// @abi action
+    void benchid(uint32_t n)
+    {
+        id_q_t q(get_self(), get_self().value);
+        run(q, n);
+    }
+
+    /// @abi action
+    void benchprio(uint32_t n)
+    {
+        prio_q_t q(get_self(), get_self().value);
+        run(q, n);
+    }
+
+private:
+    template<typename Queue>
+    void run(Queue& q, uint32_t n)
+    {
+        eosio_assert(q.empty(), "Queue must be empty in order to run the benchmark!");
+        const uint64_t key_base = 1000003ULL;
+
+        // Insert orders
+        for(uint32_t i = 0; i < n; i++) {
+            q.emplace(get_self(), key_base * (i + 1), int64_t(i));
+        }
+
+        // Partially fill every order (lookup by key + modify)
+        for(uint32_t i = 0; i < n; i++)
+        {
+            auto it = q.template find<index_key>(key_base * (i + 1));
+            auto v = *it;
+            v.value -= 1;
+            q.modify(it, std::move(v), same_payer);
+        }
+
+        // Cancel every other order (lookup by key + erase)
+        for(uint32_t i = 0; i < n; i += 2) {
+            q.erase(q.template find<index_key>(key_base * (i + 1)));
+        }
+
+        // Match remaining orders in FIFO order
+        uint32_t popped = 0;
+        while(q.pop()) {
+            popped++;
+        }
+
+        print_f("Processed % orders, matched %\n", n, popped);
+    }
+};
+
+EOSIO_DISPATCH( queue_bench, (benchseq)(benchid)(benchprio) )
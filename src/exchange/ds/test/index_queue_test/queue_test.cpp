@@ -34,10 +34,17 @@ class queue_test : public eosio::contract
         indexed_by<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>
     > q_t;
 
+    // Queue with element's key as primary key
+    typedef basic_index_queue<
+        key_policy::key_primary<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>,
+        "eosidq"_n, queue_value
+    > idq_t;
+
 public:
     queue_test(eosio::name self, eosio::name code, eosio::datastream<const char*> ds) :
         contract(self, code, ds),
-        m_q(self, self.value)
+        m_q(self, self.value),
+        m_idq(self, self.value)
     {}
 
     /// @abi action 
@@ -211,6 +218,34 @@ public:
     void runtests(eosio::name payer)
     { 
         require_auth(payer);
+        run_tests(m_q, payer);
+    }
+
+    /// @abi action
+    void runidtests(eosio::name payer)
+    {
+        require_auth(payer);
+        run_tests(m_idq, payer);
+    }
+
+    /// @abi action
+    void onerror() // handle deferred transaction error
+    {
+        auto error = onerror::from_current_action();
+        ::print_f("Error occoured! sender_id:%", error.sender_id);
+
+        auto error_trx = error.unpack_sent_trx();
+        for(const auto& a : error_trx.actions) 
+        {
+            print_f("account: %\n", name{a.account});
+            print_f("name: %\n", name{a.name});
+        }
+    }
+
+private:
+    template<typename Queue>
+    static void run_tests(Queue& m_q, eosio::name payer)
+    {
         eosio_assert(m_q.empty(), "Queue must be empty in order to run the tests!");
 
         queue_value qv1 { 1,      62651      };
@@ -288,41 +323,41 @@ public:
         eosio_assert(m_q.begin() == m_q.top()     , "m_q.begin() == m_q.top()");
 
         // Get queue element by key
-        auto qv1_it = m_q.find<index_key>(qv1.key);
+        auto qv1_it = m_q.template find<index_key>(qv1.key);
         eosio_assert(qv1_it != m_q.end()             , "qv1_it != m_q.end()");
-        eosio_assert(m_q.contains<index_key>(qv1.key), "m_q.contains<index_key>(qv1.key)");
+        eosio_assert(m_q.template contains<index_key>(qv1.key), "m_q.contains<index_key>(qv1.key)");
         eosio_assert(*qv1_it == qv1                  , "*qv1_it == qv1");
         eosio_assert(qv1_it->seq == 0                , "qv1_it->seq == 0");
         eosio_assert(qv1_it == m_q.top()             , "qv1_it == m_q.top()");
 
-        auto qv2_it = m_q.find<index_key>(qv2.key);
+        auto qv2_it = m_q.template find<index_key>(qv2.key);
         eosio_assert(qv2_it != m_q.end()             , "qv2_it != m_q.end()");
-        eosio_assert(m_q.contains<index_key>(qv2.key), "m_q.contains<index_key>(qv2.key)");
+        eosio_assert(m_q.template contains<index_key>(qv2.key), "m_q.contains<index_key>(qv2.key)");
         eosio_assert(*qv2_it == qv2                  , "*qv2_it == qv2");
         eosio_assert(qv2_it->seq == 1                , "qv2_it->seq == 1");
 
-        auto qv3_it = m_q.find<index_key>(qv3.key);
+        auto qv3_it = m_q.template find<index_key>(qv3.key);
         eosio_assert(qv3_it != m_q.end()             , "qv3_it != m_q.end()");
-        eosio_assert(m_q.contains<index_key>(qv3.key), "m_q.contains<index_key>(qv3.key)");
+        eosio_assert(m_q.template contains<index_key>(qv3.key), "m_q.contains<index_key>(qv3.key)");
         eosio_assert(*qv3_it == qv3                  , "*qv3_it == qv3");
         eosio_assert(qv3_it->seq == 2                , "qv3_it->seq == 2");
 
-        auto qv4_it = m_q.find<index_key>(qv4.key);
+        auto qv4_it = m_q.template find<index_key>(qv4.key);
         eosio_assert(qv4_it != m_q.end()             , "qv4_it != m_q.end()");
-        eosio_assert(m_q.contains<index_key>(qv4.key), "m_q.contains<index_key>(qv1.key)");
+        eosio_assert(m_q.template contains<index_key>(qv4.key), "m_q.contains<index_key>(qv1.key)");
         eosio_assert(*qv4_it == qv4                  , "*qv4_it == qv4");
         eosio_assert(qv4_it->seq == 3                , "qv4_it->seq == 3");
 
-        auto qv5_it = m_q.find<index_key>(qv5.key);
+        auto qv5_it = m_q.template find<index_key>(qv5.key);
         eosio_assert(qv5_it != m_q.end()             , "qv5_it != m_q.end()");
-        eosio_assert(m_q.contains<index_key>(qv5.key), "m_q.contains<index_key>(qv5.key)");
+        eosio_assert(m_q.template contains<index_key>(qv5.key), "m_q.contains<index_key>(qv5.key)");
         eosio_assert(*qv5_it == qv5                  , "*qv5_it == qv5");
         eosio_assert(qv5_it->seq == 4                , "qv5_it->seq == 4");
 
         // Modify top
         qv1.value = 99875911;
         m_q.modify(m_q.top(), qv1, payer);
-        qv1_it = m_q.find<index_key>(qv1.key);
+        qv1_it = m_q.template find<index_key>(qv1.key);
         eosio_assert(qv1_it != m_q.end()        , "qv1_it != m_q.end()");
         eosio_assert(*qv1_it == qv1             , "*qv1_it == qv1");
         eosio_assert(*m_q.top() == qv1          , "*m_q.top() == qv1");
@@ -331,7 +366,7 @@ public:
         // Modify qv2
         qv2.value = 3326677;
         m_q.modify(qv2_it, qv2, payer);
-        qv2_it = m_q.find<index_key>(qv2.key);
+        qv2_it = m_q.template find<index_key>(qv2.key);
         eosio_assert(qv2_it != m_q.end()        , "qv2_it != m_q.end()");
         eosio_assert(*qv2_it == qv2             , "*qv2_it == qv2");
         eosio_assert(qv2_it->seq == 1           , "qv2_it->seq == 1");
@@ -339,28 +374,28 @@ public:
         // Modify qv5
         qv5.value = 1;
         m_q.modify(qv5_it, qv5, payer);
-        qv5_it = m_q.find<index_key>(qv5.key);
+        qv5_it = m_q.template find<index_key>(qv5.key);
         eosio_assert(qv5_it != m_q.end()        , "qv5_it != m_q.end()");
         eosio_assert(*qv5_it == qv5             , "*qv5_it == qv5");
         eosio_assert(qv5_it->seq == 4           , "qv5_it->seq == 4");
 
         // remove top element
         auto opt = m_q.pop();
-        qv1_it = m_q.find<index_key>(qv1.key);
+        qv1_it = m_q.template find<index_key>(qv1.key);
         eosio_assert(opt.has_value()                  , "opt.has_value()");
         eosio_assert(*opt == qv1                      , "*opt == qv1");
         eosio_assert(qv1_it == m_q.end()              , "qv1_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv1.key), "!m_q.contains<index_key>(qv1.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv1.key), "!m_q.contains<index_key>(qv1.key)");
         eosio_assert(*m_q.top() == qv2                , "*m_q.top() == qv2");
 
         // Erase qv4
-        qv4_it = m_q.find<index_key>(qv4.key);
+        qv4_it = m_q.template find<index_key>(qv4.key);
         eosio_assert(*qv4_it == qv4, "*qv4_it == qv4");
 
         qv5_it = m_q.erase(qv4_it);
-        qv4_it = m_q.find<index_key>(qv4.key);
+        qv4_it = m_q.template find<index_key>(qv4.key);
         eosio_assert(qv4_it == m_q.end()              , "qv4_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv4.key), "!m_q.contains<index_key>(qv1.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv4.key), "!m_q.contains<index_key>(qv1.key)");
         eosio_assert(*qv5_it == qv5                   , "*qv5_it == qv5");
         eosio_assert(*m_q.top() == qv2                , "*m_q.top() == qv2");
         eosio_assert(*(++m_q.begin()) == qv3          , "*(++m_q.begin()) == qv3");
@@ -372,18 +407,18 @@ public:
         eosio_assert(*m_q.top() == qv2    , "*m_q.top() == qv2");
         eosio_assert(*(--m_q.end()) == qv6, "*(--m_q.end()) == qv6");
 
-        auto qv6_it = m_q.find<index_key>(qv6.key);
+        auto qv6_it = m_q.template find<index_key>(qv6.key);
         eosio_assert(qv6_it != m_q.end()             , "qv6_it != m_q.end()");
         eosio_assert(qv6_it->seq == 5                , "qv6_it->seq == 5");
-        eosio_assert(m_q.contains<index_key>(qv6.key), "m_q.contains<index_key>(qv6.key)");
+        eosio_assert(m_q.template contains<index_key>(qv6.key), "m_q.contains<index_key>(qv6.key)");
 
         // Remove qv2
         opt = m_q.pop();
-        qv2_it = m_q.find<index_key>(qv2.key);
+        qv2_it = m_q.template find<index_key>(qv2.key);
         eosio_assert(opt.has_value()                  , "opt.has_value()");
         eosio_assert(*opt == qv2                      , "*opt == qv2");
         eosio_assert(qv2_it == m_q.end()              , "qv2_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv2.key), "!m_q.contains<index_key>(qv2.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv2.key), "!m_q.contains<index_key>(qv2.key)");
         eosio_assert(*m_q.top() == qv3                , "*m_q.top() == qv3");
         eosio_assert(*(++m_q.begin()) == qv5          , "*(++m_q.begin()) == qv5");
         eosio_assert(*(++(++m_q.begin())) == qv6      , "*(++(++m_q.begin())) == qv6");
@@ -400,39 +435,39 @@ public:
         eosio_assert(*m_q.top() == qv3    , "*m_q.top() == qv3");
         eosio_assert(*(--m_q.end()) == qv7, "*(--m_q.end()) == qv7");
 
-        auto qv7_it = m_q.find<index_key>(qv7.key);
+        auto qv7_it = m_q.template find<index_key>(qv7.key);
         eosio_assert(qv7_it != m_q.end()             , "qv7_it != m_q.end()");
         eosio_assert(qv7_it->seq == 5                , "qv7_it->seq == 7");
-        eosio_assert(m_q.contains<index_key>(qv7.key), "m_q.contains<index_key>(qv7.key)");
+        eosio_assert(m_q.template contains<index_key>(qv7.key), "m_q.contains<index_key>(qv7.key)");
 
         // Remove qv3
         opt = m_q.pop();
-        qv3_it = m_q.find<index_key>(qv3.key);
+        qv3_it = m_q.template find<index_key>(qv3.key);
         eosio_assert(opt.has_value()                  , "opt.has_value()");
         eosio_assert(*opt == qv3                      , "*opt == qv3");
         eosio_assert(qv3_it == m_q.end()              , "qv3_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv3.key), "!m_q.contains<index_key>(qv3.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv3.key), "!m_q.contains<index_key>(qv3.key)");
         eosio_assert(*m_q.top() == qv5                , "*m_q.top() == qv5");
         eosio_assert(*(++m_q.begin()) == qv7          , "*(++m_q.begin()) == qv7)");
         eosio_assert((++(++m_q.begin())) == m_q.end() , "(++(++m_q.begin())) == m_q.end()");
 
         // Remove qv5
         opt = m_q.pop();
-        qv5_it = m_q.find<index_key>(qv5.key);
+        qv5_it = m_q.template find<index_key>(qv5.key);
         eosio_assert(opt.has_value()                  , "opt.has_value()");
         eosio_assert(*opt == qv5                      , "*opt == qv5");
         eosio_assert(qv5_it == m_q.end()              , "qv5_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv5.key), "!m_q.contains<index_key>(qv5.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv5.key), "!m_q.contains<index_key>(qv5.key)");
         eosio_assert(*m_q.top() == qv7                , "*m_q.top() == qv7");
         eosio_assert(++m_q.begin() == m_q.end()       , "++m_q.begin() == m_q.end()");
 
         // Remove qv7
         opt = m_q.pop();
-        qv7_it = m_q.find<index_key>(qv7.key);
+        qv7_it = m_q.template find<index_key>(qv7.key);
         eosio_assert(opt.has_value()                  , "opt.has_value()");
         eosio_assert(*opt == qv7                      , "*opt == qv7");
         eosio_assert(qv7_it == m_q.end()              , "qv7_it == m_q.end()");
-        eosio_assert(!m_q.contains<index_key>(qv7.key), "!m_q.contains<index_key>(qv7.key)");
+        eosio_assert(!m_q.template contains<index_key>(qv7.key), "!m_q.contains<index_key>(qv7.key)");
 
         // Check that queue is empty
         eosio_assert(m_q.top() == m_q.end()  , "m_q.top() == m_q.end()");
@@ -442,21 +477,6 @@ public:
         print("All tests have passed!");
     }
 
-    /// @abi action
-    void onerror() // handle deferred transaction error
-    {
-        auto error = onerror::from_current_action();
-        ::print_f("Error occoured! sender_id:%", error.sender_id);
-
-        auto error_trx = error.unpack_sent_trx();
-        for(const auto& a : error_trx.actions) 
-        {
-            print_f("account: %\n", name{a.account});
-            print_f("name: %\n", name{a.name});
-        }
-    }
-
-private:
     q_t::const_iterator eraser(uint64_t first_key, uint64_t num)
     {
         auto it = m_q.find<index_key>(first_key);
@@ -477,6 +497,7 @@ private:
 
 private:
     q_t m_q;
+    idq_t m_idq;
 };
 
-EOSIO_DISPATCH( queue_test, (push)(pop)(top)(bottom)(fill)(modify)(remove)(clear)(clearrange)(printkey)(printtop)(printrange)(runtests)(onerror) )
\ No newline at end of file
+EOSIO_DISPATCH( queue_test, (push)(pop)(top)(bottom)(fill)(modify)(remove)(clear)(clearrange)(printkey)(printtop)(printrange)(runtests)(runidtests)(onerror) )
\ No newline at end of file
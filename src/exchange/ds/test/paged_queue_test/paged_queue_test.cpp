@@ -0,0 +1,241 @@
+#include <eosiolib/eosio.hpp>
+
+#include "../../paged_queue.hpp"
+
+
+using namespace eosram::ds;
+using namespace eosio;
+
+
+class paged_queue_test : public eosio::contract
+{
+    struct queue_value : index_queue_element
+    {
+        uint64_t key;
+        int32_t value;
+
+        queue_value() = default;
+        queue_value(uint64_t k, int32_t v ) : key(k), value(v) {}
+        constexpr bool operator == (const queue_value& qv) const {
+            return key == qv.key && value == qv.value;
+        }
+
+        constexpr bool operator != (const queue_value& qv) { return !(*this == qv); }
+        uint64_t get_key() const { return key; }
+
+        EOSLIB_SERIALIZE_DERIVED(queue_value, index_queue_element, (key)(value))
+    };
+
+    static constexpr auto index_key = "eosqmap"_n;
+    typedef paged_queue<"eosqpages"_n, index_key,
+        queue_value,
+        const_mem_fun<queue_value, uint64_t, &queue_value::get_key>,
+        /*PageCapacity=*/2
+    > q_t;
+
+public:
+    paged_queue_test(eosio::name self, eosio::name code, eosio::datastream<const char*> ds) :
+        contract(self, code, ds),
+        m_q(self, self.value)
+    {}
+
+    /// @abi action
+    void push(uint64_t key, int32_t n)
+    {
+        m_q.push(queue_value{ key, n }, /*payer=*/get_self());
+        eosio_assert((--m_q.end())->value == n, "Failed to add element at the end of the queue!");
+        print_f("Number: % was inserted into queue", n);
+    }
+
+    /// @abi action
+    void pop()
+    {
+        ::print("Removing top element\n");
+        auto e = m_q.pop();
+        if(e){
+            print_f("Removed element: %\n", e->value);
+        }
+    }
+
+    /// @abi action
+    void printtop(uint64_t n_elements = 50)
+    {
+        auto it = m_q.begin();
+        if(it == m_q.end()) {
+            ::print("Queue is empty!");
+        }
+
+        for(; it != m_q.end() && n_elements > 0; ++it, --n_elements) {
+            print_f("[ord_idx:% key:% val: %]\n", it->seq, it->key, it->value);
+        }
+    }
+
+    /// @abi action
+    void runtests(eosio::name payer)
+    {
+        require_auth(payer);
+        eosio_assert(m_q.empty(), "Queue must be empty in order to run the tests!");
+
+        queue_value qv1 { 1,      62651      };
+        queue_value qv2 { 62262,  65654      };
+        queue_value qv3 { 554654, 565        };
+        queue_value qv4 { 489912, 1652556454 };
+        queue_value qv5 { 120654, 0          };
+
+        // Fill queue (3 pages)
+        m_q.push(qv1, payer);
+        m_q.push(qv2, payer);
+        m_q.push(qv3, payer);
+        m_q.push(qv4, payer);
+        m_q.emplace(payer, qv5.key, qv5.value);
+
+        // Iterate through queue across page boundaries
+        {
+            auto it = m_q.begin();
+            eosio_assert(*it == qv1  , "*it ==  qv1");
+            eosio_assert(it->seq == 0, "it->seq == 0");
+
+            it++;
+            eosio_assert(*it == qv2  , "*it ==  qv2");
+            eosio_assert(it->seq == 1, "it->seq == 1");
+
+            it++;
+            eosio_assert(*it == qv3  , "*it ==  qv3");
+            eosio_assert(it->seq == 2, "it->seq == 2");
+
+            it++;
+            eosio_assert(*it == qv4  , "*it ==  qv4");
+            eosio_assert(it->seq == 3, "it->seq == 3");
+
+            it++;
+            eosio_assert(*it == qv5  , "*it ==  qv5");
+            eosio_assert(it->seq == 4, "it->seq == 4");
+
+            it++;
+            eosio_assert(it == m_q.end(), "it == m_q.end()");
+
+            // Revrse
+            --it;
+            eosio_assert(*it == qv5, "*it ==  qv5");
+            --it;
+            eosio_assert(*it == qv4, "*it ==  qv4");
+            --it;
+            eosio_assert(*it == qv3, "*it ==  qv3");
+            --it;
+            eosio_assert(*it == qv2, "*it ==  qv2");
+            --it;
+            eosio_assert(*it == qv1, "*it ==  qv1");
+            eosio_assert(it == m_q.begin(), "it == m_q.begin()");
+        }
+
+        // Get queue element by key
+        auto qv3_it = m_q.find<index_key>(qv3.key);
+        eosio_assert(qv3_it != m_q.end()             , "qv3_it != m_q.end()");
+        eosio_assert(m_q.contains<index_key>(qv3.key), "m_q.contains<index_key>(qv3.key)");
+        eosio_assert(*qv3_it == qv3                  , "*qv3_it == qv3");
+        eosio_assert(qv3_it->seq == 2                , "qv3_it->seq == 2");
+        eosio_assert(!m_q.contains<index_key>(12345) , "!m_q.contains<index_key>(12345)");
+
+        // Lower bound by seq
+        eosio_assert(*m_q.lower_bound(3) == qv4      , "*m_q.lower_bound(3) == qv4");
+        eosio_assert(m_q.lower_bound(5) == m_q.end() , "m_q.lower_bound(5) == m_q.end()");
+
+        // Modify qv4
+        qv4.value = 3326677;
+        m_q.modify(m_q.find<index_key>(qv4.key), qv4, payer);
+        auto qv4_it = m_q.find<index_key>(qv4.key);
+        eosio_assert(*qv4_it == qv4                  , "*qv4_it == qv4");
+        eosio_assert(qv4_it->seq == 3                , "qv4_it->seq == 3");
+
+        // Erase qv3, half full page is merged with the next page (qv5)
+        qv4_it = m_q.erase(qv3_it);
+        eosio_assert(*qv4_it == qv4                   , "*qv4_it == qv4");
+        eosio_assert(!m_q.contains<index_key>(qv3.key), "!m_q.contains<index_key>(qv3.key)");
+
+        // Erase qv4, next element is qv5
+        auto qv5_it = m_q.erase(qv4_it);
+        eosio_assert(*qv5_it == qv5                   , "*qv5_it == qv5");
+        eosio_assert(*(++(++m_q.begin())) == qv5      , "*(++(++m_q.begin())) == qv5");
+
+        // Erase qv2, last element of the first page
+        qv5_it = m_q.erase(m_q.find<index_key>(qv2.key));
+        eosio_assert(*qv5_it == qv5                   , "*qv5_it == qv5");
+        eosio_assert(*m_q.top() == qv1                , "*m_q.top() == qv1");
+
+        // Add qv6 into last page
+        queue_value qv6 { 985798, 1264257};
+        m_q.push(qv6, payer);
+        eosio_assert(*(--m_q.end()) == qv6            , "*(--m_q.end()) == qv6");
+        eosio_assert((--m_q.end())->seq == 5          , "(--m_q.end())->seq == 5");
+
+        // Pop all
+        auto opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv1   , "*opt == qv1");
+        opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv5   , "*opt == qv5");
+        opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv6   , "*opt == qv6");
+        opt = m_q.pop();
+        eosio_assert(!opt.has_value()                 , "!opt.has_value()");
+
+        // Check that queue is empty
+        eosio_assert(m_q.top() == m_q.end()  , "m_q.top() == m_q.end()");
+        eosio_assert(m_q.begin() == m_q.end(), "m_q.begin() == m_q.end()");
+        eosio_assert(m_q.empty()             , "m_q.empty()");
+
+        // Erase while holding iterator to the next element
+        queue_value qv7  { 11, 7  };
+        queue_value qv8  { 12, 8  };
+        queue_value qv9  { 13, 9  };
+        queue_value qv10 { 14, 10 };
+        m_q.push(qv7, payer);
+        m_q.push(qv8, payer);
+        m_q.push(qv9, payer);
+        m_q.push(qv10, payer);
+        {
+            auto it = m_q.begin();
+            auto next_it = std::next(it);
+            m_q.erase(it);
+            eosio_assert(*next_it == qv8                  , "*next_it == qv8");
+            eosio_assert(m_q.begin() == next_it           , "m_q.begin() == next_it");
+
+            // Erasing the last element of the page removes the page
+            it = next_it++;
+            eosio_assert(*next_it == qv9                  , "*next_it == qv9");
+            m_q.erase(it);
+            eosio_assert(*next_it == qv9                  , "*next_it == qv9");
+            eosio_assert(m_q.begin() == next_it           , "m_q.begin() == next_it");
+
+            // Iterator to the element after the erased one in the same page
+            auto qv10_it = m_q.find<index_key>(qv10.key);
+            m_q.erase(next_it);
+            eosio_assert(*qv10_it == qv10                 , "*qv10_it == qv10");
+            eosio_assert(m_q.begin() == qv10_it           , "m_q.begin() == qv10_it");
+            eosio_assert(std::next(qv10_it) == m_q.end()  , "std::next(qv10_it) == m_q.end()");
+            eosio_assert(--m_q.end() == qv10_it           , "--m_q.end() == qv10_it");
+            eosio_assert(m_q.lower_bound(0) == qv10_it    , "m_q.lower_bound(0) == qv10_it");
+            eosio_assert(!m_q.contains<index_key>(qv9.key), "!m_q.contains<index_key>(qv9.key)");
+        }
+
+        // Push appends to the last page, which was compacted on erase
+        queue_value qv11 { 15, 11 };
+        m_q.push(qv11, payer);
+        eosio_assert(*m_q.begin() == qv10               , "*m_q.begin() == qv10");
+        eosio_assert(*(++m_q.begin()) == qv11           , "*(++m_q.begin()) == qv11");
+        eosio_assert(*m_q.find<index_key>(qv11.key) == qv11, "*m_q.find<index_key>(qv11.key) == qv11");
+        eosio_assert(m_q.find<index_key>(qv11.key)->seq == 4, "m_q.find<index_key>(qv11.key)->seq == 4");
+
+        opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv10  , "*opt == qv10");
+        opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv11  , "*opt == qv11");
+        eosio_assert(m_q.empty()                      , "m_q.empty()");
+
+        print("All tests have passed!");
+    }
+
+private:
+    q_t m_q;
+};
+
+EOSIO_DISPATCH( paged_queue_test, (push)(pop)(printtop)(runtests) )
@@ -0,0 +1,192 @@
+#include <eosiolib/eosio.hpp>
+
+#include "../../priority_index.hpp"
+
+
+using namespace eosram::ds;
+using namespace eosio;
+
+
+class priority_index_test : public eosio::contract
+{
+    struct queue_value : index_queue_element
+    {
+        uint64_t key;
+        uint32_t deadline;
+        int32_t value;
+
+        queue_value() = default;
+        queue_value(uint64_t k, uint32_t d, int32_t v ) : key(k), deadline(d), value(v) {}
+        constexpr bool operator == (const queue_value& qv) const {
+            return key == qv.key && deadline == qv.deadline && value == qv.value;
+        }
+
+        constexpr bool operator != (const queue_value& qv) { return !(*this == qv); }
+        uint64_t get_key() const { return key; }
+
+        EOSLIB_SERIALIZE_DERIVED(queue_value, index_queue_element, (key)(deadline)(value))
+    };
+
+    struct deadline_priority
+    {
+        uint128_t operator()(const queue_value& qv) const {
+            return make_priority(qv.deadline);
+        }
+    };
+
+    static constexpr auto index_key = "key"_n;
+    typedef priority_index<"eospq"_n,
+        queue_value,
+        deadline_priority,
+        indexed_by<index_key, const_mem_fun<queue_value, uint64_t, &queue_value::get_key>>
+    > q_t;
+
+public:
+    priority_index_test(eosio::name self, eosio::name code, eosio::datastream<const char*> ds) :
+        contract(self, code, ds),
+        m_q(self, self.value)
+    {}
+
+    /// @abi action
+    void push(uint64_t key, uint32_t deadline, int32_t n)
+    {
+        m_q.push(queue_value{ key, deadline, n }, /*payer=*/get_self());
+        print_f("Number: % was inserted into queue", n);
+    }
+
+    /// @abi action
+    void pop()
+    {
+        ::print("Removing top element\n");
+        auto e = m_q.pop();
+        if(e){
+            print_f("Removed element: %\n", e->value);
+        }
+    }
+
+    /// @abi action
+    void printtop(uint64_t n_elements = 50)
+    {
+        auto it = m_q.begin();
+        if(it == m_q.end()) {
+            ::print("Queue is empty!");
+        }
+
+        for(; it != m_q.end() && n_elements > 0; ++it, --n_elements) {
+            print_f("[ord_idx:% key:% deadline:% val: %]\n", it->seq, it->key, it->deadline, it->value);
+        }
+    }
+
+    /// @abi action
+    void runtests(eosio::name payer)
+    {
+        require_auth(payer);
+        eosio_assert(m_q.empty(), "Queue must be empty in order to run the tests!");
+
+        queue_value qv1 { 1,      50, 62651      };
+        queue_value qv2 { 62262,  10, 65654      };
+        queue_value qv3 { 554654, 30, 565        };
+        queue_value qv4 { 489912, 10, 1652556454 };
+        queue_value qv5 { 120654, 40, 0          };
+
+        // Fill queue
+        m_q.push(qv1, payer);
+        m_q.push(qv2, payer);
+        m_q.push(qv3, payer);
+        m_q.push(qv4, payer);
+        m_q.emplace(payer, qv5.key, qv5.deadline, qv5.value);
+
+        // Iterate through queue (ordered by deadline, equal deadlines in FIFO order)
+        {
+            auto it = m_q.begin();
+            eosio_assert(*it == qv2  , "*it ==  qv2");
+            eosio_assert(it->seq == 1, "it->seq == 1");
+
+            it++;
+            eosio_assert(*it == qv4  , "*it ==  qv4");
+            eosio_assert(it->seq == 3, "it->seq == 3");
+
+            it++;
+            eosio_assert(*it == qv3  , "*it ==  qv3");
+            eosio_assert(it->seq == 2, "it->seq == 2");
+
+            it++;
+            eosio_assert(*it == qv5  , "*it ==  qv5");
+            eosio_assert(it->seq == 4, "it->seq == 4");
+
+            it++;
+            eosio_assert(*it == qv1  , "*it ==  qv1");
+            eosio_assert(it->seq == 0, "it->seq == 0");
+
+            it++;
+            eosio_assert(it == m_q.end(), "it == m_q.end()");
+
+            // Revrse
+            --it;
+            eosio_assert(*it == qv1, "*it ==  qv1");
+            --it;
+            eosio_assert(*it == qv5, "*it ==  qv5");
+            --it;
+            eosio_assert(*it == qv3, "*it ==  qv3");
+            --it;
+            eosio_assert(*it == qv4, "*it ==  qv4");
+            --it;
+            eosio_assert(*it == qv2, "*it ==  qv2");
+            eosio_assert(it == m_q.top(), "it == m_q.top()");
+        }
+
+        // Get queue element by key
+        auto qv3_it = m_q.find<index_key>(qv3.key);
+        eosio_assert(qv3_it != m_q.end()             , "qv3_it != m_q.end()");
+        eosio_assert(m_q.contains<index_key>(qv3.key), "m_q.contains<index_key>(qv3.key)");
+        eosio_assert(*qv3_it == qv3                  , "*qv3_it == qv3");
+        eosio_assert(qv3_it->seq == 2                , "qv3_it->seq == 2");
+
+        // Lower bound
+        eosio_assert(*m_q.lower_bound(make_priority(11)) == qv3 , "*m_q.lower_bound(make_priority(11)) == qv3");
+        eosio_assert(m_q.lower_bound(make_priority(51)) == m_q.end(), "m_q.lower_bound(make_priority(51)) == m_q.end()");
+
+        // Modify qv3 priority, it should move to the top
+        qv3.deadline = 5;
+        m_q.modify(qv3_it, qv3, payer);
+        eosio_assert(*m_q.top() == qv3               , "*m_q.top() == qv3");
+        eosio_assert(m_q.top()->seq == 2             , "m_q.top()->seq == 2");
+
+        // Erase qv4
+        auto qv4_it = m_q.find<index_key>(qv4.key);
+        auto qv5_it = m_q.erase(qv4_it);
+        eosio_assert(*qv5_it == qv5                   , "*qv5_it == qv5");
+        eosio_assert(!m_q.contains<index_key>(qv4.key), "!m_q.contains<index_key>(qv4.key)");
+
+        // Pop all elements with deadline <= 40, at most 2
+        auto popped = m_q.pop_while([](const auto& qv) { return qv.deadline <= 40; }, 2);
+        eosio_assert(popped.size() == 2               , "popped.size() == 2");
+        eosio_assert(popped[0] == qv3                 , "popped[0] == qv3");
+        eosio_assert(popped[1] == qv2                 , "popped[1] == qv2");
+        eosio_assert(*m_q.top() == qv5                , "*m_q.top() == qv5");
+
+        // Pop while predicate holds
+        popped = m_q.pop_while([](const auto& qv) { return qv.deadline <= 40; });
+        eosio_assert(popped.size() == 1               , "popped.size() == 1");
+        eosio_assert(popped[0] == qv5                 , "popped[0] == qv5");
+        eosio_assert(*m_q.top() == qv1                , "*m_q.top() == qv1");
+
+        // Pop last
+        auto opt = m_q.pop();
+        eosio_assert(opt.has_value() && *opt == qv1   , "*opt == qv1");
+        opt = m_q.pop();
+        eosio_assert(!opt.has_value()                 , "!opt.has_value()");
+
+        // Check that queue is empty
+        eosio_assert(m_q.top() == m_q.end()  , "m_q.top() == m_q.end()");
+        eosio_assert(m_q.begin() == m_q.end(), "m_q.begin() == m_q.end()");
+        eosio_assert(m_q.empty()             , "m_q.empty()");
+
+        print("All tests have passed!");
+    }
+
+private:
+    q_t m_q;
+};
+
+EOSIO_DISPATCH( priority_index_test, (push)(pop)(printtop)(runtests) )
@@ -4,6 +4,11 @@
 using namespace eosram::ds;
 using namespace eosio;
 
+/**
+ * Conversion benchmark, compare action's elapsed/billed CPU time in transaction traces e.g.:
+ *   cleos push action <acc> benchconv '[1000, false]' -p <acc> --json | jq '.processed.action_traces[0].elapsed'
+ *   cleos push action <acc> benchconv '[1000, true]'  -p <acc> --json | jq '.processed.action_traces[0].elapsed'
+ */
 struct rammarket_test : public eosio::contract 
 {
     using eosio::contract::contract;
@@ -71,8 +76,83 @@ struct rammarket_test : public eosio::contract
         print_f("% = %\n", quantity, c2);
     }
 
+    // @abi action
+    // Checks integer conversion is bit-for-bit equal to double conversion over n random inputs
+    void testconv(uint64_t seed, uint32_t n)
+    {
+        eosio_assert(seed != 0, "seed must not be 0");
+        const auto es = m_rm.get_state();
+        const auto ram_sym = es.base.balance.symbol;
+        const auto eos_sym = es.quote.balance.symbol;
+
+        for(uint32_t i = 0; i < n; i++)
+        {
+            // Random market state around the current one and random trade amount
+            auto s = es;
+            s.supply.amount        = scale(s.supply.amount, seed);
+            s.base.balance.amount  = scale(s.base.balance.amount, seed);
+            s.quote.balance.amount = scale(s.quote.balance.amount, seed);
+
+            const bool to_ram = next_rand(seed) & 1;
+            const auto& c     = to_ram ? s.quote.balance : s.base.balance;
+            const asset in(1 + next_rand(seed) % std::max(c.amount, int64_t(1)), c.symbol);
+            const auto& to    = to_ram ? ram_sym : eos_sym;
+
+            auto s1 = s;
+            auto s2 = s;
+            const auto out      = s1.convert(in, to);
+            const auto out_real = s2.convert_real(in, to);
+            if(out != out_real)
+            {
+                print_f("Mismatch: supply:% base:% quote:% in:% out:% expected:%\n",
+                    s.supply, s.base.balance, s.quote.balance, in, out, out_real
+                );
+                eosio_assert(false, "Conversion mismatch!");
+            }
+        }
+
+        print_f("% conversions are equal\n", n);
+    }
+
+    // @abi action
+    void benchconv(uint32_t n, bool real)
+    {
+        const auto es = m_rm.get_state();
+        const auto ram_sym = es.base.balance.symbol;
+        const auto eos_sym = es.quote.balance.symbol;
+
+        int64_t sum = 0;
+        for(uint32_t i = 0; i < n; i++)
+        {
+            auto s = es;
+            const asset in(1000 + i * 7919, eos_sym);
+            sum += real ? s.convert_real(in, ram_sym).amount : s.convert(in, ram_sym).amount;
+        }
+
+        print_f("Converted % times, sum: %\n", n, sum);
+    }
+
+    private:
+        // xorshift64
+        static uint64_t next_rand(uint64_t& x)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            return x;
+        }
+
+        // Scales amount by random factor in range [1/8, 8)
+        static int64_t scale(int64_t amount, uint64_t& seed)
+        {
+            const uint64_t r = next_rand(seed);
+            const int32_t  sh = static_cast<int32_t>(r % 7) - 3;
+            const int64_t  a  = sh < 0 ? amount >> -sh : amount << sh;
+            return std::max<int64_t>(1, a + static_cast<int64_t>((r >> 8) % uint64_t(std::max<int64_t>(a, 1))));
+        }
+
     private:
         ram_market m_rm;
 };
 
-EOSIO_ABI( rammarket_test, (printramstate)(ramprice)(getpriceof)(buyram)(buyramfor)(sellram)(convert) );
\ No newline at end of file
+EOSIO_ABI( rammarket_test, (printramstate)(ramprice)(getpriceof)(buyram)(buyramfor)(sellram)(convert)(testconv)(benchconv) );
\ No newline at end of file
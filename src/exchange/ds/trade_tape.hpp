@@ -0,0 +1,152 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/singleton.hpp>
+
+#include <optional>
+#include <vector>
+
+#include "../constants.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * Block of consecutive trades stored in one ring slot.
+    * Each trade is appended to data as 4 varints, time and price are delta
+    * encoded to the previous trade in block (first trade is absolute):
+    *   time delta (unsigned), price delta (zigzag signed),
+    *   ram amount << 1 | taker is buyer (unsigned), eos amount (unsigned)
+    * Price is in EOS per KiB, amounts in token units.
+    */
+    struct [[eosio::table("trades"), eosio::contract("eosram.exchange")]]
+    trade_block_t
+    {
+        uint64_t slot;
+        uint64_t first_trade; // number of the first trade in block since the tape was created
+        uint32_t count;       // trades in block
+        uint32_t last_time;
+        int64_t  last_price;
+        std::vector<char> data;
+
+        uint64_t primary_key() const { return slot; }
+
+        EOSLIB_SERIALIZE(trade_block_t, (slot)(first_trade)(count)(last_time)(last_price)(data))
+    };
+
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    trade_tape_state_t
+    {
+        uint64_t trades = 0; // number of trades appended to the tape
+
+        EOSLIB_SERIALIZE(trade_tape_state_t, (trades))
+    };
+
+    namespace detail {
+        inline void put_varuint(std::vector<char>& out, uint64_t v)
+        {
+            do
+            {
+                uint8_t b = v & 0x7F;
+                v >>= 7;
+                out.push_back(static_cast<char>(b | (v ? 0x80 : 0)));
+            } while(v != 0);
+        }
+
+        inline void put_varint(std::vector<char>& out, int64_t v) {
+            put_varuint(out, (uint64_t(v) << 1) ^ uint64_t(v >> 63));
+        }
+    }
+
+   /**
+    * Recent trades kept in fixed number of ring slots (trade_tape_slots)
+    * of trade_tape_block_trades trades, oldest block is overwritten when the tape wraps around.
+    * Current block is modified in memory and written once when the tape goes out of scope.
+    */
+    class trade_tape
+    {
+        using blocks_t = multi_index<"trades"_n, trade_block_t>;
+        using state_t  = singleton<"tradetape"_n, trade_tape_state_t>;
+
+    public:
+        trade_tape(name owner) :
+            blocks_(owner, owner.value),
+            state_(owner, owner.value)
+        {}
+
+        ~trade_tape() {
+            flush();
+        }
+
+        void append(uint32_t time, int64_t price, bool taker_buy, int64_t eos_amount, int64_t ram_amount)
+        {
+            if(!block_)
+            {
+                trades_ = state_.get_or_default().trades;
+                load_block();
+            }
+            else if(block_->count == trade_tape_block_trades)
+            {
+                flush();
+                load_block();
+            }
+
+            auto& b = *block_;
+            detail::put_varuint(b.data, time - b.last_time);
+            detail::put_varint(b.data, price - b.last_price);
+            detail::put_varuint(b.data, (uint64_t(ram_amount) << 1) | (taker_buy ? 1 : 0));
+            detail::put_varuint(b.data, uint64_t(eos_amount));
+
+            b.last_time  = time;
+            b.last_price = price;
+            b.count++;
+            trades_++;
+            dirty_ = true;
+        }
+
+    private:
+        void load_block()
+        {
+            const uint64_t first = trades_ - trades_ % trade_tape_block_trades;
+            const uint64_t slot  = (first / trade_tape_block_trades) % trade_tape_slots;
+
+            auto it = blocks_.find(slot);
+            stored_ = it != blocks_.end();
+            if(stored_ && it->first_trade == first) {
+                block_ = *it;
+                return;
+            }
+
+            // New block, overwrites the oldest one
+            block_ = trade_block_t{ slot, first, 0, 0, 0, {} };
+        }
+
+        void flush()
+        {
+            if(!dirty_) {
+                return;
+            }
+
+            const auto payer = blocks_.get_code();
+            if(stored_) {
+                blocks_.modify(blocks_.find(block_->slot), payer, [&](auto& b) { b = *block_; });
+            }
+            else {
+                blocks_.emplace(payer, [&](auto& b) { b = *block_; });
+            }
+
+            state_.set(trade_tape_state_t{ trades_ }, payer);
+            stored_ = true;
+            dirty_  = false;
+        }
+
+    private:
+        blocks_t blocks_;
+        state_t state_;
+        std::optional<trade_block_t> block_;
+        uint64_t trades_ = 0;
+        bool stored_ = false;
+        bool dirty_  = false;
+    };
+}
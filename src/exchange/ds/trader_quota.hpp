@@ -0,0 +1,164 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/system.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "../constants.hpp"
+
+namespace eosram::ds {
+    using namespace eosio;
+
+   /**
+    * Admission counters of the trader.
+    * Open orders are counted by the exchange when order enters or leaves the book,
+    * orders made in the current quota window are counted when order is admitted.
+    */
+    struct [[eosio::table("traderquota"), eosio::contract("eosram.exchange")]]
+    trader_quota_t
+    {
+        name     trader;
+        uint32_t open_orders   = 0; // orders in both books
+        uint32_t window_start  = 0; // start time of the current quota window
+        uint32_t window_orders = 0; // orders made in the current quota window
+
+        bool window_active(uint32_t time, uint32_t window) const {
+            return time - window_start < window;
+        }
+
+        uint64_t primary_key() const { return trader.value; }
+
+        EOSLIB_SERIALIZE(trader_quota_t, (trader)(open_orders)(window_start)(window_orders))
+    };
+
+   /**
+    * Rows are paid by the exchange, since orders are admitted in transfer notification
+    * where trader can't be billed for RAM. Row is stale when trader has no open orders
+    * and quota window has expired, stale rows are erased to free exchange's RAM.
+    */
+    struct trader_quotas : public multi_index<"traderquota"_n, trader_quota_t>
+    {
+        trader_quotas(name owner) :
+            multi_index(owner, owner.value)
+        {}
+
+        trader_quota_t get_or_default(name trader) const
+        {
+            auto it = find(trader.value);
+            if(it != end()) {
+                return *it;
+            }
+
+            trader_quota_t q;
+            q.trader = trader;
+            return q;
+        }
+
+        void set(const trader_quota_t& q)
+        {
+            auto it = find(q.trader.value);
+            if(it != end()) {
+                modify(it, same_payer, [&](auto& r) { r = q; });
+            }
+            else {
+                emplace(get_code(), [&](auto& r) { r = q; });
+            }
+        }
+
+        /** Adds n to trader's open orders. Orders made before quotas were introduced are not counted. */
+        void add_open_orders(name trader, int32_t n, uint32_t window)
+        {
+            auto it = find(trader.value);
+            if(it == end())
+            {
+                if(n > 0) {
+                    emplace(get_code(), [&](auto& r) { r.trader = trader; r.open_orders = n; });
+                }
+                return;
+            }
+
+            const uint32_t open = n < 0 && uint32_t(-n) > it->open_orders ? 0 : it->open_orders + n;
+            if(open == 0 && !it->window_active(now(), window)) {
+                erase(it);
+            }
+            else {
+                modify(it, same_payer, [&](auto& r) { r.open_orders = open; });
+            }
+        }
+
+        /**
+         * Erases up to max_rows stale rows following trader's row, wrapping around to the first row.
+         * Removes rows of traders whose last order was closed while quota window was still active.
+         */
+        void erase_stale(name trader, uint32_t window, uint32_t max_rows)
+        {
+            const auto time = now();
+            auto it = upper_bound(trader.value);
+            for(uint32_t i = 0; i < max_rows; i++)
+            {
+                if(it == end()) {
+                    it = begin();
+                }
+                if(it == end() || it->trader == trader) {
+                    break;
+                }
+
+                if(it->open_orders == 0 && !it->window_active(time, window)) {
+                    it = erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    };
+
+   /**
+    * Changes of traders' open orders made in one action.
+    * Changes are summed per trader and written once when action finishes.
+    */
+    class open_order_counter
+    {
+    public:
+        open_order_counter(name owner) :
+            owner_(owner)
+        {}
+
+        void add(name trader, int32_t n)
+        {
+            auto it = std::find_if(deltas_.begin(), deltas_.end(), [&](const auto& d) {
+                return d.first == trader;
+            });
+
+            if(it != deltas_.end()) {
+                it->second += n;
+            } else {
+                deltas_.emplace_back(trader, n);
+            }
+        }
+
+        bool empty() const {
+            return deltas_.empty();
+        }
+
+        /**
+         * Writes summed changes. Zero change is written too,
+         * so row of trader who opened and closed order in one action can be erased.
+         */
+        void flush(uint32_t window)
+        {
+            trader_quotas quotas(owner_);
+            for(const auto& d : deltas_) {
+                quotas.add_open_orders(d.first, d.second, window);
+            }
+            deltas_.clear();
+        }
+
+    private:
+        name owner_;
+        std::vector<std::pair<name, int32_t>> deltas_;
+    };
+}
@@ -4,12 +4,19 @@
 #include "log.hpp"
 #include "order_timer.hpp"
 #include "order_utils.hpp"
+#include "policies.hpp"
 #include "trade_tools.hpp"
 #include "utils.hpp"
 
+#include "ds/auction_state.hpp"
+#include "ds/book_snapshot.hpp"
+#include "ds/exchange_config.hpp"
 #include "ds/exchange_state.hpp"
 #include "ds/memo/memo.hpp"
 #include "ds/pending_trfx_queue.hpp"
+#include "ds/ram_pool.hpp"
+#include "ds/retry_queue.hpp"
+#include "ds/sched_state.hpp"
 
 
 using namespace eosio;
@@ -18,10 +25,17 @@ using namespace eosram::ds;
 using namespace std::string_literals;
 
 constexpr auto k_admin          = "admin"_n;
+constexpr auto k_buy            = "buy"_n;
+constexpr auto k_clrauction     = "clearauction"_n;
 constexpr auto k_clrorders      = "clrorders"_n;
 constexpr auto k_execute_order  = "exec.order"_n;
 constexpr auto k_insorderexec   = "insorderexec"_n;
+constexpr auto k_insordsexec    = "insordsexec"_n;
+constexpr auto k_migrorders     = "migrorders"_n;
 constexpr auto k_order_expired  = "order.expired"_n;
+constexpr auto k_ram_pool_memo  = "rampool";
+constexpr auto k_retrysweep     = "retrysweep"_n;
+constexpr auto k_sell           = "sell"_n;
 
 
 void exchange::start_ttl_timer(order_id_t order_id, ttl_t ttl, name actor, std::string reason)
@@ -44,9 +58,31 @@ static bool stop_ttl_timer(order_id_t order_id) {
 exchange::exchange(name self, name code, datastream<const char*> ds) :
     contract(self, code, ds),
     bbook_(self),
-    sbook_(self)
+    sbook_(self),
+    tape_(self),
+    candles_(self),
+    open_orders_(self),
+    deferred_trfx_(self)
 {}
 
+exchange::~exchange()
+{
+    if(!open_orders_.empty()) {
+        open_orders_.flush(config().quota_window);
+    }
+
+    if(pending_ram_sale_ > 0)
+    {
+        // Sell RAM on rammarket for all converted orders at once,
+        // sale proceeds are split among recipients in on_transfer
+        pending_sales_t(_self).push(std::move(pending_payouts_), _self);
+        ram_market::sellrambytes(_self, pending_ram_sale_);
+
+        // Reduce issued RAM token supply
+        burn_ram_token(asset(pending_ram_sale_, RAM_SYMBOL));
+    }
+}
+
 void exchange::init(name fee_recipient)
 {
     require_auth(_self);
@@ -79,6 +115,29 @@ void exchange::setproxy(name proxy)
     state.set(s, _self);
 }
 
+void exchange::setconfig(const config_t& config)
+{
+    require_admin();
+    config.validate();
+
+    exchange_config cfg(get_self());
+    cfg.set(config, _self);
+    config_ = config;
+}
+
+const config_t& exchange::config() const
+{
+    if(!config_)
+    {
+        config_t defaults;
+        defaults.execution_limit = exchange_policy::match::execution_limit;
+
+        exchange_config cfg(get_self());
+        config_ = cfg.get_or_default(defaults);
+    }
+    return *config_;
+}
+
 name exchange::fee_recipient() const
 {
     exchange_state state(get_self());
@@ -95,7 +154,7 @@ void exchange::buy(name buyer, asset quantity, ttl_t ttl, bool force_buy)
 {
     require_auth(buyer);
     eosio_assert(buyer != _self, "Contract account cannot buy!");
-    eosio_assert(ttl_valid(ttl), "Invalid ttl!");
+    eosio_assert(ttl_valid(ttl, config().min_ttl), "Invalid ttl!");
     eosio_assert(!is_ote_order(ttl) || force_buy, "OTE order should have force_buy = True!");
 
     // Verifying asset (must be valid EOS token)
@@ -114,7 +173,7 @@ void exchange::sell(name seller, asset quantity, ttl_t ttl, bool force_sell)
 {
     require_auth(seller);
     eosio_assert(seller != _self, "Contract account cannot sell!" );
-    eosio_assert(ttl_valid(ttl), "Invalid ttl!");
+    eosio_assert(ttl_valid(ttl, config().min_ttl), "Invalid ttl!");
     eosio_assert(!is_ote_order(ttl) || force_sell, "OTE order shoud have force_sell = True!");
 
     // Verifying asset (must be valid RAM token)
@@ -140,21 +199,21 @@ void exchange::cancel(order_id_t order_id)
     require_auth(order.trader);
 
     /* Deduce fee */
-    auto da = deduct_fee(order.value, [&](const auto& amount) {
-        asset fee = cancel_order_fee(amount);
+    auto da = deduct_fee(order.value(), [&](const auto& amount) {
+        asset fee = exchange_policy::fee::cancel_order(amount);
         if(has_order_expired(order)) {
             fee.amount = 0;
         }
         return fee;
     });
 
-    order.value = da.value;
+    order.set_value(da.value);
     if(da.fee.amount > 0) {
         transfer_token(get_self(), fee_recipient(), to_token(da.fee), "Cancel order fee"s);
     }
 
     // Cancel order and return funds
-    order.convert_on_expire = has_order_expired(order) ? order.convert_on_expire : false;
+    order.set_convert_on_expire(has_order_expired(order) && order.convert_on_expire());
     order.expiration_time   = now();
 
     stop_ttl_timer(order_id);
@@ -166,148 +225,611 @@ void exchange::cancelbytxid(const tx_id_t& txid)
     cancel(get_order_id(txid));
 }
 
-void exchange::execute_order(order_id_t order_id)
+void exchange::amend(order_id_t order_id, asset new_value, ttl_t new_ttl)
 {
-    auto& buy_book  = get_order_book_of(order_id);
-    auto buy_order  = buy_book.get(order_id);
-    auto& sell_book = [&]() -> order_book& {
-        if(buy_book.get_scope() == buy_order_book::get_scope()) {
-            return sbook_;
+    LOG_DEBUG("Amending order: %", order_id);
+    require_running();
+
+    // Verify caller is the owner of order
+    auto& order_book = get_order_book_of(order_id);
+    auto it = order_book.find(order_id);
+    auto order = *it;
+    require_auth(order.trader);
+
+    eosio_assert(!has_order_expired(order), "Order has expired!");
+    eosio_assert(!is_ote_order(order), "OTE order can't be amended!");
+    eosio_assert(ttl_valid(new_ttl, config().min_ttl) && !is_ote_order(new_ttl), "Invalid ttl!");
+
+    const auto value = order.value();
+    asset_assert(new_value, value.symbol, "Invalid order value symbol!");
+    eosio_assert(new_value <= value, "Order value can only be reduced!");
+    require_min_trade_amount(new_value, "Order value does not satisfy min trade amount!");
+
+    // Order is modified in place so it keeps it's position in the book
+    order.set_value(new_value);
+    order.expiration_time = get_order_expiration_time(new_ttl, config().min_ttl);
+    order_book.modify(it, order, same_payer);
+
+    stop_ttl_timer(order_id);
+    start_ttl_timer(order_id, new_ttl, order.trader, "Order has expired"s);
+
+    // Return reduced amount
+    if(new_value < value)
+    {
+        auto da = deduct_fee(value - new_value, exchange_policy::fee::cancel_order);
+        if(da.fee.amount > 0) {
+            transfer_token(get_self(), fee_recipient(), to_token(da.fee), "Amend order fee"s);
+        }
+
+        if(da.value.amount > 0) {
+            make_transfer_to(order.trader, da.value, "Order was amended"s);
         }
+    }
+}
+
+/** Converts value into the token of order book side */
+template<order_side Side>
+static asset convert_to(const ram_market& rm, const asset& value)
+{
+    if constexpr(Side == order_side::buy) {
+        return rm.convert_to_eos(value);
+    }
+    else {
+        return rm.convert_to_ram(value);
+    }
+}
+
+template<order_side Side>
+side_order_book<Side>& exchange::book_of()
+{
+    if constexpr(Side == order_side::buy) {
         return bbook_;
-    }();
+    }
+    else {
+        return sbook_;
+    }
+}
 
-    if(preflight_check(buy_book, std::move(buy_order))) {
-        execute_trade_loop(buy_order, sell_book);
+void exchange::execute_order(order_id_t order_id)
+{
+    // Side of the order is resolved once per action, matching is specialized per side
+    auto it = bbook_.find(order_id);
+    if(it != bbook_.end()) {
+        execute_book_order<order_side::buy>(*it);
+    }
+    else {
+        execute_book_order<order_side::sell>(sbook_.get(order_id));
     }
+}
+
+template<order_side Side>
+void exchange::execute_book_order(ds::order_t order)
+{
+    using scheduler    = exchange_policy::scheduler;
+    auto& book         = book_of<Side>();
+    auto& counter_book = book_of<order_side_traits<Side>::counter_side>();
 
-    if(buy_book.contains(order_id))
+    sched_state ss(_self, book.get_scope());
+    auto sstate = ss.get_or_default();
+
+    if(preflight_check<Side>(std::move(order)))
     {
-        if(erase_order_or_update(buy_book, buy_order)) {
-            stop_ttl_timer(buy_order.id); // Order was deleted, stop it's ttl timer
+        const auto pass = execute_trade_loop<Side>(order, scheduler::execution_limit(config(), sstate));
+        if(pass.fills > 0) {
+            sweep_dust(order);
+        }
+
+        auto new_sstate = sstate;
+        scheduler::update(config(), new_sstate, pass);
+        if(new_sstate != sstate)
+        {
+            sstate = new_sstate;
+            ss.set(sstate, _self);
+        }
+    }
+
+    if(book.contains(order.id))
+    {
+        if(erase_order_or_update(book, order)) {
+            stop_ttl_timer(order.id); // Order was deleted, stop it's ttl timer
+            open_orders_.add(order.trader, -1);
         }
         // Execute another order loop?
-        else if(sell_book.top() != sell_book.end())
+        else if(counter_book.stats().orders > 0)
         {
-            order_timer t(buy_order.id);
-            t.set_permission(get_action_executor(buy_order.trader), k_active);
-            t.set_callback(_self, k_execute_order, buy_order.id);
-            t.start(order_execution_delay, get_ram_payer(buy_order.trader));
+            order_timer t(order.id);
+            t.set_permission(get_action_executor(order.trader), k_active);
+            t.set_callback(_self, k_execute_order, order.id);
+            t.start(scheduler::execution_delay(config(), sstate), get_ram_payer(order.trader));
         }
-        else if(is_ote_order(buy_order)) {
-            handle_expired_order(buy_book, std::move(buy_order), ""s);
+        else if(is_ote_order(order)) {
+            handle_expired_order(book, std::move(order), ""s);
         }
     }
 }
 
-void exchange::execute_trade(ds::order_t& o1, ds::order_t& o2)
+/** Amounts exchanged between order o1 of Side and counter order o2 */
+struct trade_amounts
 {
-    ram_market rm;
-    auto convert = [&](asset value, const symbol& sym) {
-        if(sym == EOS_SYMBOL) {
-            value = rm.convert_to_eos(value);
-        } else {
-            value = rm.convert_to_ram(value);
-        }
-        return value;
-    };
+    asset o1_receive;
+    asset o2_receive;
+};
 
-    const auto o2_value_in_o1_tkn = convert(o2.value, o1.value.symbol);
-    asset o2_receive_amount = min_asset(o1.value, o2_value_in_o1_tkn);
+template<order_side Side>
+static trade_amounts get_trade_amounts(const ram_market& rm, const order_t& o1, const order_t& o2)
+{
+    constexpr auto counter_side = order_side_traits<Side>::counter_side;
+
+    const auto o1_value = side_order_book<Side>::value_of(o1);
+    const auto o2_value = side_order_book<counter_side>::value_of(o2);
+    const auto o2_value_in_o1_tkn = convert_to<Side>(rm, o2_value);
+    asset o2_receive_amount = min_asset(o1_value, o2_value_in_o1_tkn);
     asset o1_receive_amount = [&]() {
         if(o2_receive_amount == o2_value_in_o1_tkn) {
-            return o2.value;
+            return o2_value;
         }
-        return convert(o1.value, o2.value.symbol);
+        return convert_to<counter_side>(rm, o1_value);
     }();
 
-    LOG_DEBUG("o1 value:% o2 value:%", o1.value, o2.value);
+    LOG_DEBUG("o1 value:% o2 value:%", o1_value, o2_value);
     LOG_DEBUG("o2_value_in_o1_tkn:%", o2_value_in_o1_tkn);
+    return { o1_receive_amount, o2_receive_amount };
+}
+
+template<order_side Side>
+void exchange::execute_trade(ds::order_t& o1, ds::order_t& o2, asset& o1_received, asset& o1_paid)
+{
+    ram_market rm;
+    const auto ta = get_trade_amounts<Side>(rm, o1, o2);
+    const auto& o1_receive_amount = ta.o1_receive;
+    const auto& o2_receive_amount = ta.o2_receive;
+
     LOG_DEBUG("o1_receive_amount:%", o1_receive_amount);
     LOG_DEBUG("o2_receive_amount:%", o2_receive_amount);
 
     const auto price =rm.get_ramprice();
-    deduct_fee_and_transfer_to(o1.trader, o1_receive_amount, trade_fee,
-        gen_trade_memo(o2_receive_amount, price),
-        "Trade fee"
-    );
+    if constexpr(!exchange_policy::match::batch_settlement)
+    {
+        deduct_fee_and_transfer_to(o1.trader, o1_receive_amount, exchange_policy::fee::trade,
+            gen_trade_memo(o2_receive_amount, price),
+            "Trade fee"
+        );
+    }
 
-    deduct_fee_and_transfer_to(o2.trader, o2_receive_amount, trade_fee,
+    deduct_fee_and_transfer_to(o2.trader, o2_receive_amount, exchange_policy::fee::trade,
         gen_trade_memo(o1_receive_amount, price),
         "Trade fee"
     );
 
-    o1.value -= o2_receive_amount;
-    o2.value -= o1_receive_amount;
+    // Record fill on trade tape, o1 is the taker
+    const auto& eos_amount = Side == order_side::buy ? o2_receive_amount : o1_receive_amount;
+    const auto& ram_amount = Side == order_side::buy ? o1_receive_amount : o2_receive_amount;
+    tape_.append(now(), price.amount, Side == order_side::buy, eos_amount.amount, ram_amount.amount);
+    candles_.update(now(), price.amount, eos_amount.amount, ram_amount.amount);
+
+    o1.amount -= o2_receive_amount.amount;
+    o2.amount -= o1_receive_amount.amount;
+    o1_received += o1_receive_amount;
+    o1_paid     += o2_receive_amount;
 }
 
-void exchange::execute_trade_loop(ds::order_t& buy_order, ds::order_book& sell_book)
+template<order_side Side>
+pass_stats_t exchange::execute_trade_loop(ds::order_t& order, uint32_t limit)
 {
-    auto sell_order_it = sell_book.top();
-    uint32_t limit = order_execution_limit;
+    constexpr auto counter_side = order_side_traits<Side>::counter_side;
+    auto& counter_book = book_of<counter_side>();
+
+    // What the order's trader received and paid in this pass
+    asset received(0, order_side_traits<counter_side>::value_symbol);
+    asset paid(0, order_side_traits<Side>::value_symbol);
+
+    pass_stats_t pass;
+    auto counter_order_it = counter_book.top();
 
     while(limit --> 0 &&
-        buy_order.value.amount > 0 &&
-        sell_order_it != sell_book.end())
+        order.amount > 0 &&
+        counter_order_it != counter_book.end())
     {
-        auto sell_order = *sell_order_it;
-        ++sell_order_it;
+        auto counter_order = *counter_order_it;
+        ++counter_order_it;
 
-        if(preflight_check(sell_book, std::move(sell_order)))
+        if(preflight_check<counter_side>(std::move(counter_order)))
         {
-            execute_trade(buy_order, sell_order);
-            if(erase_order_or_update(sell_book, sell_order)) {
-                stop_ttl_timer(sell_order.id); // Order was deleted, stop it's ttl timer
+            execute_trade<Side>(order, counter_order, received, paid);
+            pass.fills++;
+            sweep_dust(counter_order);
+
+            if(erase_order_or_update(counter_book, counter_order)) {
+                stop_ttl_timer(counter_order.id); // Order was deleted, stop it's ttl timer
+                open_orders_.add(counter_order.trader, -1);
             }
         }
     }
+
+    pass.backlog = order.amount > 0 && counter_order_it != counter_book.end();
+
+    if constexpr(exchange_policy::match::batch_settlement)
+    {
+        if(received.amount > 0)
+        {
+            ram_market rm;
+            deduct_fee_and_transfer_to(order.trader, received, exchange_policy::fee::trade,
+                gen_trade_memo(paid, rm.get_ramprice()),
+                "Trade fee"
+            );
+        }
+    }
+
+    return pass;
 }
 
-bool exchange::preflight_check(ds::order_book& book, ds::order_t&& order)
+template<order_side Side>
+bool exchange::preflight_check(ds::order_t&& order)
 {
     if(!is_ote_order(order) && has_order_expired(order))
     {
         stop_ttl_timer(order.id);
-        handle_expired_order(book, std::move(order), "Order has expired"s);
+        handle_expired_order(book_of<Side>(), std::move(order), "Order has expired"s);
         return false;
     }
 
    /**
     * We check here if order is trading EOS token for RAM token and if recipient of RAM token (the owner of order)
     * has already opened balance account on RAM token contract. If not, we deduce EOS token from the total
-    * amount of order value, buy ram bytes for the exchange and open balance account for the recipient
-    * paied by exchange.
+    * amount of order value, deposit it into the exchange's RAM pool and open balance account for the recipient
+    * from the pool. Order can then be executed in the same pass.
     *
     * We don't do this check for EOS token since eosio.token contract does not support open token action.
     * We then assume here, that make_transfer_to function will deduce appropriate amount of transfer fee
     * from the traded amount after the trade has been executed. Also proxy or make_transfer_to
-    * function should reserve/buy accurate amount of ram for the transfer of EOS token.
+    * function should reserve accurate amount of ram for the transfer of EOS token.
     * This is charged to this exchange's account and paid by deduced fee.
     */
-    if(is_buy_order(order) && // Buying ram token?
-       !is_account_owner_of(order.trader, ram_symbol()))
+    if constexpr(Side == order_side::buy) // Buying ram token?
     {
-        auto da = deduct_fee(order.value, token_transfer_fee);
+        if(!has_token_balance(order.trader, ram_symbol()))
+        {
+            auto da = deduct_fee(side_order_book<Side>::value_of(order), [&](const asset& amount) {
+                return exchange_policy::fee::transfer_in_eos(amount, config().transfer_fee_in_ram);
+            });
+
+            /*
+            * If deduced amount is less then 1, the make_transfer_to function should
+            * consume traded RAM tokens as transfer fee.
+            */
+            if(da.value.amount > 0)
+            {
+                ram_pool pool(_self);
+                pool.deposit(da.fee);
+                open_token_balance(order.trader, ram_symbol());
+
+                order.amount = da.value.amount;
+            }
+        }
+    }
 
-        /*
-        * If deduced amount is less then 1, the make_transfer_to function should
-        * consume traded RAM tokens as transfer fee.
-        */
-        if(da.value.amount > 0)
+    return true;
+}
+
+void exchange::quote(name side, int64_t amount, ttl_t ttl, bool convert)
+{
+    eosio_assert(!exchange_policy::match::call_auction, "Quote is not supported in call auction!");
+    eosio_assert(ttl_valid(ttl, config().min_ttl), "Invalid ttl!");
+    eosio_assert(!is_ote_order(ttl) || convert, "OTE order should have convert = True!");
+
+    std::string result;
+    if(side == k_buy) {
+        result = quote_order<order_side::buy>(amount, ttl, convert);
+    }
+    else if(side == k_sell) {
+        result = quote_order<order_side::sell>(amount, ttl, convert);
+    }
+    else {
+        eosio_assert(false, "Invalid side, must be buy or sell!");
+    }
+
+    // Quote is returned as the error message of the action,
+    // so the action never has any side effects.
+    eosio_assert(false, result.c_str());
+}
+
+template<order_side Side>
+std::string exchange::quote_order(int64_t amount, ttl_t ttl, bool convert)
+{
+    using traits         = order_side_traits<Side>;
+    using counter_traits = counter_side_traits<Side>;
+    constexpr auto counter_side = traits::counter_side;
+
+    const asset value(amount, traits::value_symbol);
+    require_min_trade_amount(value, "Trade value does not satisfy min trade amount!");
+
+    ram_market rm;
+    order_t order(0, value, _self, get_order_expiration_time(ttl, config().min_ttl), convert);
+    asset received(0, counter_traits::value_symbol);
+    asset paid(0, traits::value_symbol);
+    asset fee(0, counter_traits::value_symbol);
+
+    // Walk the counter book the way the matcher does
+    uint32_t fills = 0;
+    auto& counter_book = book_of<counter_side>();
+    for(auto it = counter_book.top(); it != counter_book.end() && order.amount > 0 && fills < quote_max_fills; ++it)
+    {
+        auto counter_order = *it;
+        if(!is_ote_order(counter_order) && has_order_expired(counter_order)) {
+            continue; // Would be removed by the matcher
+        }
+
+        if constexpr(counter_side == order_side::buy)
         {
-            ram_market rm;
-            rm.buyram(_self, _self, da.fee);
+            if(!has_token_balance(counter_order.trader, ram_symbol()))
+            {
+                auto da = deduct_fee(side_order_book<counter_side>::value_of(counter_order), [&](const asset& a) {
+                    return exchange_policy::fee::transfer_in_eos(a, config().transfer_fee_in_ram);
+                });
+
+                if(da.value.amount > 0) {
+                    counter_order.amount = da.value.amount;
+                }
+            }
+        }
 
-            auto fee = to_token(rm.convert_to_ram(da.fee));
-            open_token_balance(order.trader, fee, /*burn_token=*/false);
+        const auto ta = get_trade_amounts<Side>(rm, order, counter_order);
+        order.amount -= ta.o2_receive.amount;
+        received     += ta.o1_receive;
+        paid         += ta.o2_receive;
+        if constexpr(!exchange_policy::match::batch_settlement) {
+            fee += exchange_policy::fee::trade(ta.o1_receive);
+        }
+        fills++;
+    }
 
-            order.value.amount = da.value.amount;
-            book.modify(order, get_ram_payer(order.trader));
-            return false;
+    if constexpr(exchange_policy::match::batch_settlement)
+    {
+        if(received.amount > 0) {
+            fee = exchange_policy::fee::trade(received);
         }
     }
 
-    return true;
+    // OTE order converts whatever is left on rammarket, other orders rest in the book
+    asset resting(order.amount, traits::value_symbol);
+    asset converted(0, counter_traits::value_symbol);
+    if(is_ote_order(ttl) && resting.amount > 0)
+    {
+        if constexpr(Side == order_side::buy)
+        {
+            converted = rm.convert_to_ram(deduct_fee(resting, ram_market_fee).value);
+            converted = deduct_fee(converted, exchange_policy::fee::issue_token).value;
+        }
+        else
+        {
+            converted = deduct_fee(rm.convert_to_eos(resting), ram_market_fee).value;
+            converted = deduct_fee(converted, exchange_policy::fee::burn_token).value;
+        }
+        resting.amount = 0;
+    }
+
+    // Average price of fills per KiB
+    const auto& eos = Side == order_side::buy ? paid : received;
+    const auto& ram = Side == order_side::buy ? received : paid;
+    const asset avg_price(ram.amount > 0 ? int64_t((int128_t(eos.amount) * 1024) / ram.amount) : 0, EOS_SYMBOL);
+
+    // Charged only if trader doesn't hold the received token yet
+    const auto open_fee = exchange_policy::fee::transfer_in_eos(value, config().transfer_fee_in_ram);
+
+    return "{\"fills\":"s         + to_string(static_cast<int32_t>(fills)) +
+        ",\"paid\":\""s             + to_string(paid) +
+        "\",\"received\":\""s      + to_string(received - fee) +
+        "\",\"trade_fee\":\""s     + to_string(fee) +
+        "\",\"avg_price\":\""s     + to_string(avg_price) +
+        "\",\"market_price\":\""s  + to_string(rm.get_ramprice()) +
+        "\",\"resting\":\""s       + to_string(resting) +
+        "\",\"converted\":\""s     + to_string(converted) +
+        "\",\"balance_open_fee\":\""s + to_string(open_fee) +
+        "\"}"s;
+}
+
+void exchange::snapshot(name side, uint64_t cursor, uint32_t limit)
+{
+    eosio_assert(limit > 0, "Invalid limit!");
+
+    std::string result;
+    if(side == k_buy) {
+        result = snapshot_book(bbook_, cursor, limit);
+    }
+    else if(side == k_sell) {
+        result = snapshot_book(sbook_, cursor, limit);
+    }
+    else {
+        eosio_assert(false, "Invalid side, must be buy or sell!");
+    }
+
+    // Snapshot is returned as the error message of the action,
+    // so the action never has any side effects.
+    eosio_assert(false, result.c_str());
+}
+
+std::string exchange::snapshot_book(const order_book& book, uint64_t cursor, uint32_t limit) const
+{
+    book_snapshot_t snap;
+    snap.version = book.stats().version;
+
+    uint32_t n = std::min(limit, snapshot_max_orders);
+    snap.orders.reserve(n);
+
+    auto it = book.lower_bound(cursor);
+    for(; it != book.end() && n --> 0; ++it) {
+        snap.orders.push_back({ it->id, it->amount, it->trader, it->expiration_time, uint8_t(it->flags & ~order_flags::legacy_layout) });
+    }
+
+    if(it != book.end())
+    {
+        snap.cursor = it.internal_idx();
+        snap.more   = true;
+    }
+
+    const auto data = pack(snap);
+    return "{\"snapshot\":\""s + to_hex(data.data(), data.size()) + "\"}"s;
+}
+
+void exchange::clearauction()
+{
+    require_auth(_self);
+    eosio_assert(exchange_policy::match::call_auction, "Call auction is not enabled!");
+
+    auction_state as(_self);
+    as.set(auction_state_t{}, _self);
+
+    clear_auction();
+    if(!bbook_.empty() || !sbook_.empty()) {
+        schedule_auction();
+    }
+}
+
+void exchange::schedule_auction()
+{
+    auction_state as(_self);
+    auto s = as.get_or_default();
+    if(s.next_clearing > now()) {
+        return; // Already scheduled
+    }
+
+    const auto interval = config().auction_interval;
+    s.next_clearing = now() + interval;
+    as.set(s, _self);
+
+    order_timer t(0);
+    t.set_permission(get_self(), k_active);
+    t.set_callback(get_self(), k_clrauction);
+    t.start(interval, get_self(), /*replace=*/true);
+}
+
+static int64_t pro_rata(int64_t volume, int64_t amount, int64_t total) {
+    return total > 0 ? int64_t((int128_t(volume) * amount) / total) : 0;
+}
+
+static int64_t pro_rata_sum(const std::vector<order_t>& orders, int64_t volume, int64_t total)
+{
+    int64_t sum = 0;
+    for(const auto& o : orders) {
+        sum += pro_rata(volume, o.amount, total);
+    }
+    return sum;
+}
+
+/**
+ * Clears order books in call auction at single uniform price, given by the rammarket
+ * conversion of all buy orders. The short side of the book is filled completely, the long
+ * side is filled pro-rata to order value. Each side pays it's pro-rata share rounded down
+ * and receives pro-rata share of what the other side has actually paid,
+ * so the exchange never pays out more than it has received.
+ */
+void exchange::clear_auction()
+{
+    std::vector<order_t> buys;
+    std::vector<order_t> sells;
+    const int64_t total_eos = collect_auction_orders<order_side::buy>(buys);
+    const int64_t total_ram = collect_auction_orders<order_side::sell>(sells);
+
+    int64_t eos_volume = 0;
+    int64_t ram_volume = 0;
+    ram_market rm;
+    if(total_eos > 0 && total_ram > 0)
+    {
+        const int64_t demand_ram = rm.convert_to_ram(asset(total_eos, EOS_SYMBOL)).amount;
+        if(demand_ram <= total_ram)
+        {
+            eos_volume = total_eos;
+            ram_volume = demand_ram;
+        }
+        else
+        {
+            eos_volume = pro_rata(total_eos, total_ram, demand_ram);
+            ram_volume = total_ram;
+        }
+    }
+
+    LOG_DEBUG("Clearing auction total_eos:% total_ram:% eos_volume:% ram_volume:%",
+        total_eos, total_ram, eos_volume, ram_volume
+    );
+
+    const auto price = rm.get_ramprice();
+    const int64_t eos_paid = pro_rata_sum(buys, eos_volume, total_eos);
+    const int64_t ram_paid = pro_rata_sum(sells, ram_volume, total_ram);
+    settle_auction_side<order_side::buy>(buys, total_eos, eos_volume, ram_paid, price);
+    settle_auction_side<order_side::sell>(sells, total_ram, ram_volume, eos_paid, price);
+}
+
+template<order_side Side>
+int64_t exchange::collect_auction_orders(std::vector<order_t>& orders)
+{
+    auto& book = book_of<Side>();
+    int64_t total = 0;
+
+    auto it = book.top();
+    while(it != book.end() && orders.size() < auction_max_orders)
+    {
+        auto order = *it;
+        ++it;
+
+        const auto amount = order.amount;
+        if(preflight_check<Side>(std::move(order)))
+        {
+            // Preflight deducted balance opening fee, order might not trade in this clearing
+            if(order.amount != amount) {
+                book.modify(order, same_payer);
+            }
+
+            total += order.amount;
+            orders.push_back(std::move(order));
+        }
+    }
+
+    return total;
+}
+
+template<order_side Side>
+void exchange::settle_auction_side(std::vector<order_t>& orders, int64_t total, int64_t volume, int64_t received, const asset& price)
+{
+    using traits         = order_side_traits<Side>;
+    using counter_traits = counter_side_traits<Side>;
+    auto& book = book_of<Side>();
+
+    // Remainder of rounding goes to the last order
+    int64_t remaining = received;
+    for(std::size_t i = 0; i < orders.size(); i++)
+    {
+        auto& order = orders[i];
+        const int64_t pays     = pro_rata(volume, order.amount, total);
+        const int64_t receives = i + 1 < orders.size() ? pro_rata(received, order.amount, total) : remaining;
+        remaining -= receives;
+
+        // Order didn't trade in this clearing, it stays in the book unchanged
+        if(pays == 0 && receives == 0)
+        {
+            if(is_ote_order(order)) {
+                handle_expired_order(book, std::move(order), ""s);
+            }
+            continue;
+        }
+
+        if(receives > 0)
+        {
+            deduct_fee_and_transfer_to(order.trader, asset(receives, counter_traits::value_symbol), exchange_policy::fee::trade,
+                gen_trade_memo(asset(pays, traits::value_symbol), price),
+                "Trade fee"
+            );
+        }
+
+        order.amount -= pays;
+        sweep_dust(order);
+        if(erase_order_or_update(book, order)) {
+            stop_ttl_timer(order.id); // Order was deleted, stop it's ttl timer
+            open_orders_.add(order.trader, -1);
+        }
+        else if(is_ote_order(order)) {
+            handle_expired_order(book, std::move(order), ""s);
+        }
+    }
 }
 
 template<typename Lambda>
@@ -325,13 +847,27 @@ void exchange::make_transfer_to(name recipient, const asset& amount, std::string
     // Token transfer fee applies only if recipient is not already
     // an owner of token he's about to receive.
     auto ext_amount = to_token(amount);
-    if(!is_account_owner_of(recipient, ext_amount.get_extended_symbol()))
+    if(!has_token_balance(recipient, ext_amount.get_extended_symbol()))
     {
-        auto da = deduct_fee(ext_amount.quantity, token_transfer_fee);
+        auto da = deduct_fee(ext_amount.quantity, [&](const asset& amount) {
+            return exchange_policy::fee::transfer(amount, config().transfer_fee_in_ram);
+        });
         ext_amount.quantity.amount = da.value.amount;
 
-        if(da.value.amount > 0) {
-            open_token_balance(recipient, to_token(da.fee), true);
+        if(da.value.amount > 0)
+        {
+            ram_pool pool(_self);
+            if(da.fee.symbol == RAM_SYMBOL)
+            {
+                // Burned token's RAM backing is moved to the pool
+                burn_ram_token(da.fee);
+                pool.deposit_bytes(da.fee.amount);
+            }
+            else {
+                pool.deposit(da.fee);
+            }
+
+            open_token_balance(recipient, ext_amount.get_extended_symbol());
         }
         else
         {
@@ -346,29 +882,42 @@ void exchange::make_transfer_to(name recipient, const asset& amount, std::string
     }
 }
 
-void exchange::open_token_balance(const name owner, const extended_asset& buy_ram_amount, const bool burn_token)
+void exchange::open_token_balance(const name owner, const extended_symbol& ext_sym)
 {
-    const auto& sym = buy_ram_amount.quantity.symbol;
-    if(sym == RAM_SYMBOL)
+    auto& sym = const_cast<extended_symbol&>(ext_sym);
+    if(sym.get_symbol() == RAM_SYMBOL)
     {
-        if(burn_token) {
-            burn_ram_token(buy_ram_amount.quantity);
-        }
+        ram_pool pool(_self);
+        pool.allocate(config().transfer_fee_in_ram, ram_pool_low_watermark * config().transfer_fee_in_ram);
 
         constexpr static auto k_open = "open"_n;
-        dispatch_inline(buy_ram_amount.contract, k_open, {{ _self, k_active }},
-            std::make_tuple(owner, sym, _self)
+        dispatch_inline(sym.get_contract(), k_open, {{ _self, k_active }},
+            std::make_tuple(owner, sym.get_symbol(), _self)
         );
+
+        // Open action is executed after this action, remember
+        // the new holder so it's not charged again in this pass.
+        opened_ram_balances_.push_back(owner);
     }
-    else if(sym == EOS_SYMBOL && !transfer_proxy())
+    else if(sym.get_symbol() == EOS_SYMBOL && !transfer_proxy())
     {
-        /* We buy ram needed for the transfer, if transfer proxy is not available. */
+        /* We reserve ram needed for the transfer, if transfer proxy is not available. */
         // Note: when open action is supported by eosio.token add call to open action.
-        ram_market rm;
-        rm.buyram(_self, _self, buy_ram_amount.quantity);
+        ram_pool pool(_self);
+        pool.allocate(config().transfer_fee_in_ram, ram_pool_low_watermark * config().transfer_fee_in_ram);
     }
 }
 
+bool exchange::has_token_balance(name account, const extended_symbol& ext_sym) const
+{
+    if(is_account_owner_of(account, ext_sym)) {
+        return true;
+    }
+
+    return ext_sym == ram_symbol() &&
+        std::find(opened_ram_balances_.begin(), opened_ram_balances_.end(), account) != opened_ram_balances_.end();
+}
+
 void exchange::transfer_token(const name from, const name to, const extended_asset& amount, std::string memo, bool deferred)
 {
     eosio_assert(amount.quantity.is_valid(), "Cannot transfer invalid amount!" );
@@ -381,7 +930,7 @@ void exchange::transfer_token(const name from, const name to, const extended_ass
 
     if(deferred)
     {
-        deferred_transfer(/*ram_payer=*/has_auth(to) ? to : from,
+        deferred_trfx_.add(/*ram_payer=*/has_auth(to) ? to : from,
             proxy, { from, k_active },
             from, to, amount, std::move(memo)
         );
@@ -401,6 +950,8 @@ void exchange::execute_memo_cmd(const memo_cmd_make_order& cmd, name account, co
     require_auth(account);
     asset_assert(value, EOS_SYMBOL, RAM_SYMBOL, "The value must be in EOS or RAM!");
     require_min_trade_amount(value, "Trade value does not satisfy min trade amount!");
+    eosio_assert(ttl_valid(cmd.ttl(), config().min_ttl), "Invalid ttl!");
+    admit_orders(account, 1);
 
     // Generate order id from current txid
     order_id_t order_id = get_order_id(get_txid());
@@ -411,43 +962,135 @@ void exchange::execute_memo_cmd(const memo_cmd_make_order& cmd, name account, co
     );
 }
 
+/**
+ * Checks trader's quotas before order is made, so flooding the book
+ * is rejected before any order row or timer is created.
+ */
+void exchange::admit_orders(name trader, uint32_t n)
+{
+    trader_quotas quotas(_self);
+    auto q = quotas.get_or_default(trader);
+    eosio_assert(q.open_orders + n <= config().max_open_orders, "Too many open orders!");
+
+    const auto time = now();
+    if(!q.window_active(time, config().quota_window))
+    {
+        q.window_start  = time;
+        q.window_orders = 0;
+    }
+
+    q.window_orders += n;
+    eosio_assert(q.window_orders <= config().max_window_orders, "Too many orders made in short time, try again later!");
+    quotas.set(q);
+
+    // Erase a few rows left by traders whose window expired after last order was closed
+    quotas.erase_stale(trader, config().quota_window, quota_sweep_rows);
+}
+
 void exchange::insert_and_execute_order(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool convert_on_expire)
 {
     require_auth(_self);
     //DEBUG_ASSERT(has_auth(trader), "insert_and_execute_order: Missing required authority for trader's account!");
 
     if(value.symbol == EOS_SYMBOL) {
-        make_buy_order(order_id, trader, value, ttl, convert_on_expire);
+        make_order_and_execute<order_side::buy>(order_id, trader, value, ttl, convert_on_expire);
     }
     else if(value.symbol == RAM_SYMBOL) {
-        make_sell_order(order_id, trader, value, ttl, convert_on_expire);
+        make_order_and_execute<order_side::sell>(order_id, trader, value, ttl, convert_on_expire);
     }
 }
 
-void exchange::make_buy_order(order_id_t order_id, name buyer, const asset& value, ttl_t ttl, bool force_buy)
+template<order_side Side>
+void exchange::make_order_and_execute(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool exec_on_expire)
 {
-    DEBUG_ASSERT(value.symbol == EOS_SYMBOL, "make_buy_order: value must be in EOS!");
-    make_order_and_execute(bbook_, order_id, buyer, value, ttl, force_buy);
+    make_order<Side>(order_id, trader, value, ttl, exec_on_expire);
+    if constexpr(exchange_policy::match::call_auction) {
+        schedule_auction(); // Order waits for the next clearing
+    }
+    else {
+        execute_book_order<Side>(book_of<Side>().get(order_id));
+    }
 }
 
-void exchange::make_sell_order(order_id_t order_id, name seller, const asset& value, ttl_t ttl, bool force_sell)
+template<order_side Side>
+void exchange::make_order(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool exec_on_expire)
 {
-    DEBUG_ASSERT(value.symbol == RAM_SYMBOL, "make_sell_order: value must be in RAM!");
-    make_order_and_execute(sbook_, order_id, seller, value, ttl, force_sell);
-}
+    DEBUG_ASSERT(has_auth(_self), "make_order:  Missing required authority for owner's account!");
+    DEBUG_ASSERT(value.symbol == order_side_traits<Side>::value_symbol, "make_order: invalid order value symbol!");
 
-void exchange::make_order_and_execute(ds::order_book& book, order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool exec_on_expire)
-{
-    DEBUG_ASSERT(has_auth(_self), "make_order_and_execute:  Missing required authority for owner's account!");
-    auto order_expire_time = get_order_expiration_time(ttl);
+    auto& book = book_of<Side>();
+    auto order_expire_time = get_order_expiration_time(ttl, config().min_ttl);
     book.emplace_order(get_ram_payer(trader), order_id, trader, value, order_expire_time, exec_on_expire);
+    open_orders_.add(trader, 1);
 
-    DEBUG_ASSERT(order_exists(order_id), "make_sell_order: failed to insert order into order book!");
+    DEBUG_ASSERT(book.contains(order_id), "make_order: failed to insert order into order book!");
     LOG_DEBUG("New order was inserted into order book. order_id=%", order_id);
 
-    // Start order expiration timer and execute order
+    // Start order expiration timer
     start_ttl_timer(order_id, ttl, trader, "Order has expired"s);
-    execute_order(order_id);
+}
+
+// Make batch of orders
+void exchange::execute_memo_cmd(const memo_cmd_make_orders& cmd, name account, const asset& value)
+{
+    require_running();
+    require_auth(account);
+    asset_assert(value, EOS_SYMBOL, RAM_SYMBOL, "The value must be in EOS or RAM!");
+
+    auto orders = cmd.split(value);
+    for(const auto& o : orders)
+    {
+        require_min_trade_amount(o.value, "Trade value does not satisfy min trade amount!");
+        eosio_assert(ttl_valid(o.ttl, config().min_ttl), "Invalid ttl!");
+    }
+    admit_orders(account, orders.size());
+
+    // Generate order ids from current txid, orders get consecutive ids
+    order_id_t order_id = get_order_id(get_txid());
+
+    // Insert orders and execute them in single action
+    dispatch_inline(_self, k_insordsexec, {{ _self, k_active }},
+        std::make_tuple(order_id, account, std::move(orders))
+    );
+}
+
+void exchange::insert_and_execute_orders(order_id_t first_order_id, name trader, std::vector<order_entry_t> orders)
+{
+    require_auth(_self);
+    eosio_assert(!orders.empty(), "No orders!");
+
+    if(orders.front().value.symbol == EOS_SYMBOL) {
+        make_orders_and_execute<order_side::buy>(first_order_id, trader, orders);
+    }
+    else if(orders.front().value.symbol == RAM_SYMBOL) {
+        make_orders_and_execute<order_side::sell>(first_order_id, trader, orders);
+    }
+}
+
+template<order_side Side>
+void exchange::make_orders_and_execute(order_id_t first_order_id, name trader, const std::vector<order_entry_t>& orders)
+{
+    // All orders are in the book before the first one is executed,
+    // so they are matched in FIFO order within this action.
+    order_id_t order_id = first_order_id;
+    for(const auto& o : orders) {
+        make_order<Side>(order_id++, trader, o.value, o.ttl, o.convert_on_expire);
+    }
+
+    if constexpr(exchange_policy::match::call_auction) {
+        schedule_auction(); // Orders wait for the next clearing
+    }
+    else
+    {
+        auto& book = book_of<Side>();
+        for(order_id = first_order_id; order_id != first_order_id + orders.size(); order_id++)
+        {
+            auto it = book.find(order_id);
+            if(it != book.end()) {
+                execute_book_order<Side>(*it);
+            }
+        }
+    }
 }
 
 // Cancel order
@@ -466,9 +1109,11 @@ void exchange::handle_expired_order(order_book& book, order_t order, std::string
     LOG_DEBUG("Order expired id= %", order.id);
 
     book.erase(order);
+    open_orders_.add(order.trader, -1);
 
     // Buy/Sell RAM token on system ram market
-    if(order.convert_on_expire && order.value.amount > 0)
+    const auto value = order.value();
+    if(order.convert_on_expire() && value.amount > 0)
     {
         ram_market rm;
         const auto price = rm.get_ramprice();
@@ -479,18 +1124,19 @@ void exchange::handle_expired_order(order_book& book, order_t order, std::string
             LOG_DEBUG("Buying RAM token from system contract");
 
             /* Calculate output RAM - market fee */
-            auto out_ram_in_eos   = deduct_fee(order.value, ram_market_fee).value;
+            auto out_ram_in_eos   = deduct_fee(value, ram_market_fee).value;
             auto out_ram_quantity = rm.convert_to_ram(out_ram_in_eos);
 
             // Buy RAM from ram market and transfer token;
-            rm.buyram(get_self(), get_self(), order.value);
+            rm.buyram(get_self(), get_self(), value);
+            candles_.update(now(), price.amount, value.amount, out_ram_quantity.amount);
 
             // Issue RAM token
             issue_ram_token(out_ram_quantity);
 
             // Transfer converted funds to trader
-            deduct_fee_and_transfer_to(order.trader, out_ram_quantity, issue_token_fee,
-                gen_trade_memo(order.value, price),
+            deduct_fee_and_transfer_to(order.trader, out_ram_quantity, exchange_policy::fee::issue_token,
+                gen_trade_memo(value, price),
                 "RAM token issuance fee"
             );
         }
@@ -500,24 +1146,35 @@ void exchange::handle_expired_order(order_book& book, order_t order, std::string
         {
             LOG_DEBUG("Selling RAM token to system contract");
 
-            // Buy RAM from rammarket and transfer token;
-            rm.sellrambytes(_self, order.value.amount);
-
-            // Reduce issued RAM token supply
-            burn_ram_token(order.value);
+            // RAM is sold on rammarket and RAM token is burned for all
+            // converted orders at once, when action finishes (see ~exchange).
+            pending_ram_sale_ += value.amount;
+            candles_.update(now(), price.amount, rm.convert_to_eos(value).amount, value.amount);
 
-            pending_trfx_queue_t pending_trfx_reips(_self);
-            pending_trfx_reips.push(order.trader,
-                gen_trade_memo(order.value, price),
-                get_ram_payer(order.trader)
-            );
+            add_pending_payout(pending_payouts_, order.trader, value.amount, price.amount);
         }
     }
     // Return remaining order's funds back to trader
-    else if(!order.convert_on_expire)
+    else if(!order.convert_on_expire())
     {
         LOG_DEBUG("Returning remaining order's funds back to order issuer");
-        make_transfer_to(order.trader, order.value, std::move(reason));
+        make_transfer_to(order.trader, value, std::move(reason));
+    }
+}
+
+/**
+ * Returns remaining value of partially filled order to it's trader if it
+ * no longer satisfies min trade amount, so the order is removed from the book
+ * instead of occupying it's head with value which can't be traded.
+ */
+void exchange::sweep_dust(order_t& order)
+{
+    const auto value = order.value();
+    if(value.amount > 0 && !is_min_trade_amount(value))
+    {
+        LOG_DEBUG("Sweeping dust of order id=% value=%", order.id, value);
+        make_transfer_to(order.trader, value, "Returning order remainder below min trade amount"s);
+        order.amount = 0;
     }
 }
 
@@ -557,10 +1214,18 @@ void exchange::on_notification(name receiver, name code, name action)
             eosio_assert(code == receiver, "insorderexec action's are only valid from the contract's account");
         );
 
+        DISPATCH_SIGNAL(k_insordsexec, exchange::insert_and_execute_orders,
+            eosio_assert(code == receiver, "insordsexec action's are only valid from the contract's account");
+        );
+
         DISPATCH_SIGNAL(k_order_expired, exchange::on_order_expired,
             IF_CONTRACT_SIGNAL
         );
 
+        DISPATCH_SIGNAL(k_retrysweep, exchange::retry_sweep,
+            IF_CONTRACT_SIGNAL
+        );
+
         DISPATCH_SIGNAL("onerror"_n, exchange::on_error,
             eosio_assert(code == k_eosio, "onerror action's are only valid from the \"eosio\" system account");
         );
@@ -575,18 +1240,38 @@ void exchange::on_transfer(name from, name to, asset quantity, std::string memo)
         eosio_assert(quantity.amount > 0, "Transferred quantity must be positive value");
         on_payment_received(from, std::move(quantity), std::move(memo));
     }
+    else if(from == fee_recipient() && to == _self &&
+            quantity.symbol == EOS_SYMBOL && memo == k_ram_pool_memo)
+    {
+        // Fee recipient pre-funds RAM pool
+        ram_pool pool(_self);
+        pool.deposit(quantity);
+    }
     else if(from == EOSIO_RAM_ACCOUNT && quantity.symbol == EOS_SYMBOL)
     {
-        pending_trfx_queue_t pending_trfx_reips(_self);
-        auto recipient = pending_trfx_reips.pop();
-        if(recipient)
+        // Payouts of the RAM sale of this transfer, split received EOS
+        // among recipients pro rata to sold RAM.
+        auto payouts = pending_sales_t(_self).pop_last();
+        if(!payouts || payouts->empty()) {
+            return;
+        }
+
+        int64_t total_ram = 0;
+        for(const auto& p : *payouts) {
+            total_ram += p.ram;
+        }
+
+        auto out_eos_quantity = deduct_fee(quantity, ram_market_fee).value;
+        auto remaining = out_eos_quantity.amount;
+        for(std::size_t i = 0; i < payouts->size(); i++)
         {
-            auto out_eos_quantity = deduct_fee(quantity,
-                ram_market_fee
-            ).value;
+            const auto& p = (*payouts)[i];
+            auto amount = i + 1 < payouts->size() ?
+                int64_t((int128_t(out_eos_quantity.amount) * p.ram) / total_ram) : remaining;
+            remaining -= amount;
 
-            deduct_fee_and_transfer_to(recipient->name, out_eos_quantity, burn_token_fee,
-                recipient->trfx_memo,
+            deduct_fee_and_transfer_to(p.name, asset(amount, EOS_SYMBOL), exchange_policy::fee::burn_token,
+                gen_trade_memo(asset(p.ram, RAM_SYMBOL), asset(p.price, EOS_SYMBOL)),
                 "Burn RAM token fee",
                 /*deferred=*/true
             );
@@ -622,6 +1307,12 @@ void exchange::on_payment_received(name from, asset quantity, std::string memo)
             auto cmd = parser.get<memo_cmd_cancel_order>();
             return execute_memo_cmd(cmd, from, quantity);
         }
+        case memo_cmd_make_orders::type_as_int():
+        {
+            LOG_DEBUG("Executing cmd: make_orders");
+            auto cmd = parser.get<memo_cmd_make_orders>();
+            return execute_memo_cmd(cmd, from, quantity);
+        }
         default:
         DEBUG_ASSERT(false, "Invalid memo cmd!"); // No reason to come here
     }
@@ -639,31 +1330,144 @@ void exchange::on_order_expired(order_id_t order_id, std::string reason)
 void exchange::on_error(onerror error)
 {
     timer_id tid(error.sender_id);
+    if(tid.action_name() == k_retrysweep)
+    {
+        schedule_retry_sweep(config().onerror_resend_delay);
+        return;
+    }
+
     auto book_ptr = get_order_book_ptr_of(tid.order_id());
     if(book_ptr != nullptr ||
        tid.action_name() == k_clrorders ||
+       tid.action_name() == k_clrauction ||
+       tid.action_name() == k_migrorders ||
        tid.action_name() == k_deferredtrfx)
     {
-        LOG_DEBUG("Resending failed tx for order_id: %", tid.order_id());
+        LOG_DEBUG("Queueing failed tx for order_id: %", tid.order_id());
 
         auto dftx_payer = _self;
         if(book_ptr != nullptr) {
             dftx_payer= book_ptr->find(tid.order_id())->trader;
         }
-        else if(tid.action_name() == k_deferredtrfx) {
-            dftx_payer= name(tid.order_id());
-        }
 
         if(!has_auth(dftx_payer)) {
             dftx_payer = _self;
         }
 
-        transaction tx = error.unpack_sent_trx();
-        tx.delay_sec = onerror_resend_delay;
-        tx.send(error.sender_id, dftx_payer, true);
+        // Failed deferred transactions of order slow down execution scheduling of it's book
+        if(book_ptr != nullptr)
+        {
+            sched_state ss(_self, book_ptr->get_scope());
+            auto sstate = ss.get_or_default();
+            sstate.record_failure(now());
+            ss.set(sstate, _self);
+        }
+
+        // Repeated failures of the same transaction are coalesced into single retry entry
+        retry_queue retries(_self);
+        auto it = retries.find(error.sender_id);
+        retry_t r;
+        if(it != retries.end()) {
+            r = *it;
+        }
+
+        r.sender_id = error.sender_id;
+        r.payer     = dftx_payer;
+        r.in_flight = false;
+        r.trx       = std::move(error.sent_trx);
+        r.attempts++;
+
+        if(r.attempts > retry_max_attempts)
+        {
+            LOG_DEBUG("Moving failed tx for order_id: % to dead letters", tid.order_id());
+            dead_letters dl(_self);
+            dl.emplace(_self, [&](auto& d) {
+                d.id        = dl.available_primary_key();
+                d.sender_id = r.sender_id;
+                d.attempts  = r.attempts - 1;
+                d.failed_at = now();
+                d.trx       = std::move(r.trx);
+            });
+
+            if(it != retries.end()) {
+                retries.erase(it);
+            }
+            return;
+        }
+
+        // Exponential backoff
+        const uint32_t delay = std::min(config().onerror_resend_delay << (r.attempts - 1), max_config_delay);
+        r.next_attempt = now() + delay;
+        if(it != retries.end()) {
+            retries.modify(it, std::move(r), same_payer);
+        }
+        else {
+            retries.push(std::move(r), _self);
+        }
+
+        schedule_retry_sweep();
     }
 }
 
+/** Resends due failed deferred transactions in batch */
+void exchange::retry_sweep()
+{
+    require_auth(_self);
+
+    retry_queue retries(_self);
+    const auto time = now();
+    auto due = retries.pop_while([&](const retry_t& r) {
+        return r.next_attempt <= time;
+    }, retry_sweep_batch);
+
+    for(auto& r : due)
+    {
+        if(r.in_flight) {
+            continue; // Resent transaction didn't fail again
+        }
+
+        LOG_DEBUG("Resending failed tx for order_id: %", timer_id(r.sender_id).order_id());
+        transaction tx = unpack<transaction>(r.trx);
+        tx.delay_sec = 0;
+        tx.send(r.sender_id, r.payer, true);
+
+        // Keep attempt count in case it fails again
+        r.in_flight    = true;
+        r.next_attempt = time + retry_in_flight_timeout;
+        retries.push(std::move(r), _self);
+    }
+
+    schedule_retry_sweep();
+}
+
+/** Schedules retry sweep for the earliest retry entry, replaces already scheduled sweep */
+void exchange::schedule_retry_sweep(uint32_t min_delay)
+{
+    retry_queue retries(_self);
+    auto it = retries.top();
+    if(it == retries.end()) {
+        return;
+    }
+
+    const auto time = now();
+    const uint32_t delay = std::max(it->next_attempt > time ? it->next_attempt - time : 0U, min_delay);
+
+    order_timer t(0);
+    t.set_permission(get_self(), k_active);
+    t.set_callback(get_self(), k_retrysweep);
+    t.start(delay, get_self(), /*replace=*/true);
+}
+
+void exchange::clrdeadltr(uint64_t id)
+{
+    require_admin();
+
+    dead_letters dl(_self);
+    auto it = dl.find(id);
+    eosio_assert(it != dl.end(), "Dead letter doesn't exist!");
+    dl.erase(it);
+}
+
 order_book& exchange::get_order_book_of(order_id_t order_id, const char* error_msg)
 {
     auto* opt_book = get_order_book_ptr_of(order_id);
@@ -745,7 +1549,8 @@ void exchange::clrallorders(std::string reason)
 void exchange::clrorders(const symbol& sym, std::string reason)
 {
     require_admin();
-    std::size_t limit = 8;
+    const std::size_t max_transfers = config().clrorders_batch_size;
+    uint32_t rows = clrorders_max_rows;
 
     order_book& book = [&]() -> order_book& {
         if(sym == EOS_SYMBOL) {
@@ -754,20 +1559,86 @@ void exchange::clrorders(const symbol& sym, std::string reason)
         return sbook_;
     }();
 
+   /**
+    * Transfers are the most expensive part of the pass, so refunds are
+    * aggregated per trader and the pass ends when next order would need
+    * more than max_transfers transfers or clrorders_max_rows orders were removed.
+    */
+    std::vector<std::pair<name, int64_t>> refunds;
+    refunds.reserve(max_transfers);
+
     auto it = book.begin();
-    while(it != book.end() && limit --> 0)
+    while(it != book.end() && rows --> 0)
     {
-        make_transfer_to(it->trader, it->value, std::move(reason));
+        auto rit = std::find_if(refunds.begin(), refunds.end(), [&](const auto& r) {
+            return r.first == it->trader;
+        });
+
+        if(rit == refunds.end())
+        {
+            if(refunds.size() == max_transfers) {
+                break;
+            }
+            rit = refunds.insert(rit, { it->trader, 0 });
+        }
+
+        rit->second += it->amount;
+        open_orders_.add(it->trader, -1);
         it = book.erase(it);
     }
 
+    for(const auto& r : refunds) {
+        make_transfer_to(r.first, asset(r.second, sym), reason);
+    }
+
+    // Continue in the next block
     if(!book.empty())
     {
         auto sym_code = static_cast<order_id_t>(sym.raw());
         order_timer t(sym_code);
         t.set_permission(get_self(), k_admin);
         t.set_callback(get_self(), k_clrorders, sym, std::move(reason));
-        t.start(5, get_self());
+        t.start(0, get_self());
+    }
+}
+
+void exchange::migrorders(const symbol& sym, uint64_t from_seq, uint32_t limit)
+{
+    require_admin();
+    eosio_assert(limit > 0, "Invalid limit!");
+
+    order_book& book = [&]() -> order_book& {
+        if(sym == EOS_SYMBOL) {
+            return bbook_;
+        }
+        return sbook_;
+    }();
+
+    // Rewrite legacy order rows in packed layout
+    uint32_t migrated = 0;
+    uint32_t n = limit;
+    auto it = book.lower_bound(from_seq);
+    for(; it != book.end() && n --> 0; ++it)
+    {
+        if(it->has_legacy_layout())
+        {
+            book.modify(it, *it, same_payer);
+            migrated++;
+        }
+    }
+
+    print_f("Migrated % orders, order row size: % -> % bytes, released: % bytes\n",
+        migrated, order_t::legacy_row_size, order_t::packed_row_size,
+        migrated * (order_t::legacy_row_size - order_t::packed_row_size)
+    );
+
+    if(it != book.end())
+    {
+        auto sym_code = static_cast<order_id_t>(sym.raw());
+        order_timer t(sym_code);
+        t.set_permission(get_self(), k_admin);
+        t.set_callback(get_self(), k_migrorders, sym, it.internal_idx(), limit);
+        t.start(0, get_self());
     }
 }
 
@@ -783,4 +1654,4 @@ void exchange::require_running() const
 }
 
 EOSIO_DISPATCH( eosram::exchange,
-    (init)(buy)(sell)(cancel)(cancelbytxid)(start)(stop)(setfeerecip)(setproxy)(clrallorders)(clrorders) )
\ No newline at end of file
+    (init)(buy)(sell)(cancel)(cancelbytxid)(amend)(start)(stop)(setfeerecip)(setproxy)(setconfig)(quote)(snapshot)(clearauction)(clrallorders)(clrorders)(migrorders)(clrdeadltr) )
\ No newline at end of file
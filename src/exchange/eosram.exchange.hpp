@@ -4,13 +4,23 @@
 #include <eosiolib/name.hpp>
 
 #include "constants.hpp"
+#include "utils.hpp"
+#include "ds/candles.hpp"
+#include "ds/exchange_config.hpp"
 #include "ds/ram_market.hpp"
 #include "ds/order_book.hpp"
+#include "ds/pending_trfx_queue.hpp"
+#include "ds/trade_tape.hpp"
+#include "ds/trader_quota.hpp"
+#include "ds/retry_queue.hpp"
+#include "ds/sched_state.hpp"
 #include "ds/memo/memo.hpp"
 
 #include <algorithm>
 #include <cmath>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace eosram {
     using namespace eosio;
@@ -19,6 +29,7 @@ namespace eosram {
     {
     public:
         exchange(name self, name code, datastream<const char*> ds);
+        ~exchange();
 
     //public_api:
        /**
@@ -43,6 +54,29 @@ namespace eosram {
         [[eosio::action]]
         void cancelbytxid(const tx_id_t& txid);
 
+       /**
+        * Reduces order's value and/or sets new ttl of order in place, order keeps it's position in the book.
+        * Reduced amount minus cancel fee is returned to trader.
+        */
+        [[eosio::action]]
+        void amend(order_id_t order_id, asset new_value, ttl_t new_ttl);
+
+       /**
+        * Simulates buy or sell order of amount against current order books
+        * and rammarket, without any side effects. Action always fails and
+        * the quote is returned in JSON as the error message.
+        */
+        [[eosio::action]]
+        void quote(name side, int64_t amount, ttl_t ttl, bool convert);
+
+       /**
+        * Exports up to limit orders of buy or sell book starting at seq cursor,
+        * without any side effects. Action always fails and the packed
+        * ds::book_snapshot_t is returned in hex as the error message.
+        */
+        [[eosio::action]]
+        void snapshot(name side, uint64_t cursor, uint32_t limit);
+
     //private_api:
         [[eosio::action]]
         void init(name fee_recipient);
@@ -53,6 +87,10 @@ namespace eosram {
         [[eosio::action]]
         void setproxy(name proxy);
 
+        /** Sets runtime execution parameters */
+        [[eosio::action]]
+        void setconfig(const ds::config_t& config);
+
         [[eosio::action]]
         void start();
 
@@ -65,39 +103,80 @@ namespace eosram {
         [[eosio::action]]
         void clrorders(const symbol& sym, std::string reason);
 
+        /** Clears order books in call auction, scheduled by the exchange when call auction is enabled */
+        [[eosio::action]]
+        void clearauction();
+
+        /** Rewrites up to limit orders, starting at from_seq, from legacy into packed row layout */
+        [[eosio::action]]
+        void migrorders(const symbol& sym, uint64_t from_seq, uint32_t limit);
+
+        /** Removes failed deferred transaction from dead letters */
+        [[eosio::action]]
+        void clrdeadltr(uint64_t id);
+
         // signal handler
         static void on_notification(name receiver, name code, name action);
 
     private:
         void execute_memo_cmd(const ds::memo_cmd_make_order& cmd, name account, const asset& value);
         void execute_memo_cmd(const ds::memo_cmd_cancel_order& cmd, name account, const asset& value);
+        void execute_memo_cmd(const ds::memo_cmd_make_orders& cmd, name account, const asset& value);
         void start_ttl_timer(order_id_t order_id, ttl_t ttl, name actor, std::string reason);
+        void admit_orders(name trader, uint32_t n);
 
         ds::order_book& get_order_book_of(order_id_t order_id, const char* error_msg = "Order doesn't exists");
         ds::order_book* get_order_book_ptr_of(order_id_t id);
         bool order_exists(order_id_t id) const;
 
+        template<ds::order_side Side>
+        ds::side_order_book<Side>& book_of();
+
         void execute_order(order_id_t order_id);
-        void execute_trade(ds::order_t& o1, ds::order_t& o2);
-        void execute_trade_loop(ds::order_t& buy_order, ds::order_book& sell_book);
+        template<ds::order_side Side>
+        void execute_book_order(ds::order_t order);
+        template<ds::order_side Side>
+        void execute_trade(ds::order_t& o1, ds::order_t& o2, asset& o1_received, asset& o1_paid);
+        template<ds::order_side Side>
+        ds::pass_stats_t execute_trade_loop(ds::order_t& order, uint32_t limit);
         void insert_and_execute_order(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool force_execution);
-        void make_buy_order(order_id_t order_id, name buyer, const asset& value, ttl_t ttl, bool force_buy);
-        void make_sell_order(order_id_t order_id, name seller, const asset& value, ttl_t ttl, bool force_sell);
-        void make_order_and_execute(ds::order_book&, order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool convert_on_expire);
-        bool preflight_check(ds::order_book& book, ds::order_t&& order);
+        void insert_and_execute_orders(order_id_t first_order_id, name trader, std::vector<ds::order_entry_t> orders);
+        template<ds::order_side Side>
+        void make_order_and_execute(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool convert_on_expire);
+        template<ds::order_side Side>
+        void make_orders_and_execute(order_id_t first_order_id, name trader, const std::vector<ds::order_entry_t>& orders);
+        template<ds::order_side Side>
+        void make_order(order_id_t order_id, name trader, const asset& value, ttl_t ttl, bool convert_on_expire);
+        template<ds::order_side Side>
+        bool preflight_check(ds::order_t&& order);
+
+        template<ds::order_side Side>
+        std::string quote_order(int64_t amount, ttl_t ttl, bool convert);
+        std::string snapshot_book(const ds::order_book& book, uint64_t cursor, uint32_t limit) const;
+
+        void schedule_auction();
+        void clear_auction();
+        template<ds::order_side Side>
+        int64_t collect_auction_orders(std::vector<ds::order_t>& orders);
+        template<ds::order_side Side>
+        void settle_auction_side(std::vector<ds::order_t>& orders, int64_t total, int64_t volume, int64_t received, const asset& price);
 
         template<typename Lambda>
         void deduct_fee_and_transfer_to(name recipient, const asset& amount, Lambda&& fee, std::string transfer_memo, std::string fee_info, bool deferred = false);
         void make_transfer_to(const name recipient, const asset& amount, std::string memo, bool deferred = false);
-        void open_token_balance(name owner, const extended_asset& buy_ram_amount, const bool burn_token);
+        void open_token_balance(name owner, const extended_symbol& sym);
+        bool has_token_balance(name account, const extended_symbol& sym) const;
         void transfer_token(const name from, const name to, const extended_asset& amount, std::string memo = "", bool deferred = false);
 
         void handle_expired_order(ds::order_book& book, ds::order_t order, std::string reason);
+        void sweep_dust(ds::order_t& order);
+        void schedule_retry_sweep(uint32_t min_delay = 0);
         void issue_ram_token(const asset& amount);
         void burn_ram_token(const asset& amount);
 
         // signal heandlers
         void on_error(onerror error);
+        void retry_sweep();
         void on_order_expired(order_id_t order_id, std::string reason);
         void on_payment_received(name from, asset quantity, std::string memo);
         void on_transfer(name from, name to, asset quantity, std::string memo);
@@ -113,9 +192,18 @@ namespace eosram {
         void require_running() const;
         name fee_recipient() const;
         name transfer_proxy() const;
+        const ds::config_t& config() const;
 
     private:
         ds::buy_order_book bbook_;
         ds::sell_order_book sbook_;
+        ds::trade_tape tape_;                   // recent trades, written when action finishes
+        ds::candles candles_;                   // price candles, written when action finishes
+        ds::open_order_counter open_orders_;    // traders' open orders, written when action finishes
+        std::vector<name> opened_ram_balances_; // RAM token balances opened in current action
+        int64_t pending_ram_sale_ = 0;          // RAM of convert-on-expire sell orders to be sold when action finishes
+        std::vector<ds::pending_trfx_recip_t> pending_payouts_; // payouts of pending_ram_sale_, recorded when RAM is sold
+        mutable std::optional<ds::config_t> config_; // loaded once per action
+        deferred_transfer_batch deferred_trfx_;      // deferred transfers of the action, sent when action finishes
     };
 } // eosram
\ No newline at end of file
@@ -28,19 +28,21 @@ namespace eosram {
         return issue_token_fee(a);
     };
 
-    constexpr auto token_transfer_fee = [](const asset& amount) -> asset 
+    constexpr auto token_transfer_fee_in_eos = [](const asset&, int64_t fee_in_ram = transfer_fee_in_ram) -> asset {
+        ds::ram_market rm;
+        return rm.convert_to_eos(asset(fee_in_ram, RAM_SYMBOL));
+    };
+
+    constexpr auto token_transfer_fee_in_ram = [](const asset&, int64_t fee_in_ram = transfer_fee_in_ram) -> asset {
+        return asset(fee_in_ram, RAM_SYMBOL);
+    };
+
+    constexpr auto token_transfer_fee = [](const asset& amount, int64_t fee_in_ram = transfer_fee_in_ram) -> asset
     {
-        auto fee = amount;
-        if(fee.symbol == EOS_SYMBOL) 
-        {
-            ds::ram_market rm;
-            fee = rm.convert_to_eos(asset(transfer_fee_in_ram, RAM_SYMBOL));
-        }
-        else {
-            fee.amount = transfer_fee_in_ram;
+        if(amount.symbol == EOS_SYMBOL) {
+            return token_transfer_fee_in_eos(amount, fee_in_ram);
         }
-
-        return fee;
+        return token_transfer_fee_in_ram(amount, fee_in_ram);
     };
 
     constexpr auto cancel_order_fee = [](const asset& amount) -> asset {
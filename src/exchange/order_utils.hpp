@@ -36,7 +36,7 @@ namespace eosram {
         return ttl <= infinite_ttl;
     }
 
-    inline constexpr bool ttl_valid(ttl_t ttl) {
+    inline constexpr bool ttl_valid(ttl_t ttl, int32_t min_ttl = eosram::min_ttl) {
         return ttl_infinite(ttl) || is_ote_order(ttl) || ttl >= min_ttl;
     }
 
@@ -61,19 +61,19 @@ namespace eosram {
     * @param ttl
     * @returns expiration time
     */
-    static uint32_t get_order_expiration_time(ttl_t ttl)
+    static uint32_t get_order_expiration_time(ttl_t ttl, int32_t min_ttl = eosram::min_ttl)
     {
-        eosio_assert(ttl_valid(ttl), "Invlid ttl!");
+        eosio_assert(ttl_valid(ttl, min_ttl), "Invlid ttl!");
         return ttl_infinite(ttl) ? detail::inf_time_ :
                is_ote_order(ttl) ? detail::ote_time_ : now() + ttl;
     }
 
     static bool is_buy_order(const ds::order_t& order) {
-        return order.value.symbol == EOS_SYMBOL;
+        return !order.is_sell_order();
     }
 
     static bool is_sell_order(const ds::order_t& order) {
-        return order.value.symbol == RAM_SYMBOL;
+        return order.is_sell_order();
     }
 
     /**
@@ -86,7 +86,7 @@ namespace eosram {
     */
     static bool erase_order_or_update(ds::order_book& book, const ds::order_t& order)
     {
-        if(order.value.amount > 0LL)
+        if(order.amount > 0LL)
         {
             book.modify(order, eosio::same_payer);
             return false;
@@ -0,0 +1,127 @@
+#pragma once
+#include <eosiolib/asset.hpp>
+
+#include "constants.hpp"
+#include "fees.hpp"
+#include "ds/exchange_config.hpp"
+#include "ds/order_book.hpp"
+#include "ds/sched_state.hpp"
+
+#include <algorithm>
+
+namespace eosram {
+   /**
+    * Compile-time strategies of the exchange's matching core.
+    * Policy bundle is selected per build target (see CMakeLists.txt),
+    * so every deployed wasm has it's policies inlined.
+    */
+    namespace policy {
+
+        /** Exchange fee schedule */
+        struct default_fees
+        {
+            static constexpr auto trade           = trade_fee;
+            static constexpr auto cancel_order    = cancel_order_fee;
+            static constexpr auto issue_token     = issue_token_fee;
+            static constexpr auto burn_token      = burn_token_fee;
+            static constexpr auto transfer        = token_transfer_fee;
+            static constexpr auto transfer_in_eos = token_transfer_fee_in_eos;
+        };
+
+       /**
+        * Adapts execution limit and delay to the observed load.
+        * While passes leave backlog in the counter book, batch size doubles and next pass
+        * is scheduled for the next block. Passes without fills and recent failed deferred
+        * transactions exponentially back off the delay, failures also halve the batch size.
+        */
+        struct adaptive_scheduler
+        {
+            static uint32_t execution_limit(const ds::config_t& config, const ds::sched_state_t& state) {
+                return state.batch_size > 0 ? state.batch_size : config.execution_limit;
+            }
+
+            static uint32_t execution_delay(const ds::config_t& config, const ds::sched_state_t& state)
+            {
+                uint32_t shift = state.idle_passes;
+                if(state.has_recent_failures(now())) {
+                    shift = std::max(shift, state.failures);
+                }
+
+                if(shift > 0) {
+                    return std::min(config.execution_delay << shift, max_config_delay);
+                }
+                return state.backlog ? 0 : config.execution_delay;
+            }
+
+            static void update(const ds::config_t& config, ds::sched_state_t& state, const ds::pass_stats_t& pass)
+            {
+                const bool failing = state.has_recent_failures(now());
+                if(!failing) {
+                    state.failures = 0;
+                }
+
+                state.idle_passes = pass.fills == 0 ? std::min(state.idle_passes + 1, sched_max_backoff_shift) : 0;
+                state.backlog     = pass.backlog;
+
+                uint32_t batch = execution_limit(config, state);
+                if(failing) {
+                    batch = std::max(batch / 2, 1U);
+                }
+                else if(pass.backlog) {
+                    batch = std::min(batch * 2, max_order_execution_limit);
+                }
+                else {
+                    batch = config.execution_limit;
+                }
+                state.batch_size = batch;
+            }
+        };
+
+        /** Every fill is settled to both traders immediately */
+        struct continuous_match
+        {
+            static constexpr uint32_t execution_limit  = order_execution_limit; // default of config_t::execution_limit
+            static constexpr bool     batch_settlement = false;
+            static constexpr bool     call_auction     = false;
+        };
+
+       /**
+        * Fills of the incoming order are accumulated over the execution pass
+        * and settled to it's trader with single transfer.
+        * Resting orders are still settled per fill.
+        */
+        struct batch_settlement_match
+        {
+            static constexpr uint32_t execution_limit  = batch_execution_limit; // default of config_t::execution_limit
+            static constexpr bool     batch_settlement = true;
+            static constexpr bool     call_auction     = false;
+        };
+
+       /**
+        * Orders are not matched on arrival but accumulated and periodically
+        * cleared in call auction at single uniform price (see exchange::clear_auction).
+        */
+        struct call_auction_match
+        {
+            static constexpr uint32_t execution_limit  = order_execution_limit; // default of config_t::execution_limit
+            static constexpr bool     batch_settlement = false;
+            static constexpr bool     call_auction     = true;
+        };
+    }
+
+    template<typename FeePolicy, typename SchedulerPolicy, typename MatchPolicy>
+    struct exchange_policies
+    {
+        using fee       = FeePolicy;
+        using scheduler = SchedulerPolicy;
+        using match     = MatchPolicy;
+    };
+
+#if defined(BATCH_SETTLEMENT)
+    using exchange_policy = exchange_policies<policy::default_fees, policy::adaptive_scheduler, policy::batch_settlement_match>;
+#elif defined(CALL_AUCTION)
+    using exchange_policy = exchange_policies<policy::default_fees, policy::adaptive_scheduler, policy::call_auction_match>;
+#else
+    using exchange_policy = exchange_policies<policy::default_fees, policy::adaptive_scheduler, policy::continuous_match>;
+#endif
+}
@@ -1,15 +1,19 @@
 #pragma once
+#include <eosiolib/action.h>
 #include <eosiolib/action.hpp>
 #include <eosiolib/asset.hpp>
+#include <eosiolib/singleton.hpp>
 #include <eosiolib/crypto.h>
 #include <eosiolib/system.h>
 #include <eosiolib/transaction.h>
 #include <eosiolib/types.h>
 
+#include <algorithm>
 #include <climits>
 #include <string>
 #include <utility>
 #include <type_traits>
+#include <vector>
 
 #include "constants.hpp"
 #include "order_timer.hpp"
@@ -63,18 +67,79 @@ namespace eosram {
         return ta;
     }
 
-    static void deferred_transfer(eosio::name ram_payer, eosio::name proxy, eosio::permission_level perm, eosio::name from, eosio::name to, extended_asset amount, std::string memo)
+    struct [[eosio::table, eosio::contract("eosram.exchange")]]
+    deferred_transfer_state_t
     {
-        eosio::action ta = make_transfer_action(
-            proxy, perm, from, to, amount, memo
-        );
+        uint64_t seq = 0; // number of deferred transfer transactions sent
 
-        eosio::transaction tx;
-        tx.actions.push_back(std::move(ta));
+        EOSLIB_SERIALIZE(deferred_transfer_state_t, (seq))
+    };
 
-        uint128_t sender_id = timer_id(ram_payer.value, k_deferredtrfx);
-        tx.send(sender_id, ram_payer, true);
-    }
+   /**
+    * Collects transfers made during the action and sends them as actions
+    * of single deferred transaction per recipient and RAM payer when the batch is destroyed.
+    * Transfers to different recipients are kept in separate transactions, so recipient
+    * which rejects the transfer can't fail transfers to others.
+    * Sender id is made from sequence number of sent transaction, so batches of different
+    * actions, even identical actions in one transaction, don't replace each other.
+    */
+    class deferred_transfer_batch
+    {
+        using state_t = eosio::singleton<"dtrfxstate"_n, deferred_transfer_state_t>;
+
+        struct batch_tx
+        {
+            eosio::name recipient;
+            eosio::name ram_payer;
+            eosio::transaction tx;
+        };
+
+    public:
+        deferred_transfer_batch(eosio::name owner) :
+            owner_(owner)
+        {}
+
+        ~deferred_transfer_batch() {
+            send();
+        }
+
+        void add(eosio::name ram_payer, eosio::name proxy, eosio::permission_level perm, eosio::name from, eosio::name to, extended_asset amount, std::string memo)
+        {
+            auto it = std::find_if(txs_.begin(), txs_.end(), [&](const auto& b) {
+                return b.recipient == to && b.ram_payer == ram_payer;
+            });
+
+            if(it == txs_.end()) {
+                it = txs_.insert(it, { to, ram_payer, eosio::transaction() });
+            }
+
+            it->tx.actions.push_back(make_transfer_action(
+                proxy, std::move(perm), from, to, std::move(amount), std::move(memo)
+            ));
+        }
+
+        void send()
+        {
+            if(txs_.empty()) {
+                return;
+            }
+
+            state_t state(owner_, owner_.value);
+            auto s = state.get_or_default();
+            for(auto& b : txs_)
+            {
+                uint128_t sender_id = timer_id(s.seq++, k_deferredtrfx);
+                b.tx.send(sender_id, b.ram_payer);
+            }
+
+            state.set(s, owner_);
+            txs_.clear();
+        }
+
+    private:
+        eosio::name owner_;
+        std::vector<batch_tx> txs_;
+    };
 
     inline void inline_transfer(eosio::name proxy, eosio::permission_level perm, eosio::name from, eosio::name to, extended_asset amount, std::string memo)
     {